@@ -0,0 +1,106 @@
+#include "Benchmarks.h"
+#include "MemoryBlock.h"
+#include <algorithm>
+#include <random>
+namespace VulkanCookbook {
+	namespace {
+		struct Range { VkDeviceSize Offset, Size; uint32_t Segment; };
+
+		//The small size classes are the narrowest, so they are where a class head that is too short for
+		//the request would show. Fills a block with sub-SmallSize requests of mixed alignment, frees every
+		//third one to mix in reused ranges, and checks that no two allocations overlap.
+		bool CheckSmallAllocations() {
+			MemoryBlock block(VK_NULL_HANDLE, 64 * 1024, nullptr, PoolStrategy::Tlsf);
+			std::vector<Range> ranges;
+			for (uint32_t round = 0; round < 2; ++round) {
+				for (uint32_t request = 0; ; ++request) {
+					VkDeviceSize size = 1 + (request * 37 + round * 11) % 127;
+					VkDeviceSize alignment = 1ull << ((request * 5 + round) % 8);
+					Range range = { 0, size, 0 };
+					if (!block.Allocate(size, alignment, range.Offset, range.Segment))
+						break;
+					if (range.Offset % alignment != 0 || range.Offset + size > block.Size) {
+						std::cout << "A small allocation is misaligned or out of its block." << std::endl;
+						return false;
+					}
+					ranges.push_back(range);
+				}
+				for (size_t index = ranges.size(); index-- > 0;)
+					if (round == 0 && index % 3 == 0) {
+						block.Free(ranges[index].Segment, ranges[index].Size);
+						ranges.erase(ranges.begin() + index);
+					}
+			}
+			std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) { return a.Offset < b.Offset; });
+			for (size_t index = 1; index < ranges.size(); ++index)
+				if (ranges[index - 1].Offset + ranges[index - 1].Size > ranges[index].Offset) {
+					std::cout << "Two small allocations overlap." << std::endl;
+					return false;
+				}
+			return true;
+		}
+
+		//Allocates count ranges of 256 B to 64 KiB and frees them in random order; with churn, then also
+		//times freeing one range and allocating another with half of them live.
+		bool TimeAllocations(PoolStrategy strategy, const char* name, uint32_t count, bool churn) {
+			std::mt19937 random(1);
+			std::vector<VkDeviceSize> sizes(count);
+			for (VkDeviceSize& size : sizes)
+				size = 256ull << (random() % 9);
+			std::vector<Range> ranges(count);
+			MemoryBlock block(VK_NULL_HANDLE, 8ull * 1024 * 1024 * 1024, nullptr, strategy);
+
+			uint32_t next = 0;
+			bool allocated = true;
+			double allocate = NanosecondsPerCall(count, [&] {
+				Range& range = ranges[next];
+				range.Size = sizes[next++];
+				allocated &= block.Allocate(range.Size, 256, range.Offset, range.Segment);
+			});
+			if (!allocated) {
+				std::cout << "The " << name << " block ran out of space." << std::endl;
+				return false;
+			}
+			std::shuffle(ranges.begin(), ranges.end(), random);
+			next = 0;
+			double release = NanosecondsPerCall(count, [&] {
+				block.Free(ranges[next].Segment, ranges[next].Size);
+				++next;
+			});
+			if (!block.Empty()) {
+				std::cout << "The " << name << " block is not empty after freeing everything." << std::endl;
+				return false;
+			}
+
+			if (!churn) {
+				std::cout << name << ": allocate " << allocate << " ns, free " << release << " ns per call" << std::endl;
+				return true;
+			}
+			for (uint32_t index = 0; index < count / 2; ++index)
+				block.Allocate(ranges[index].Size, 256, ranges[index].Offset, ranges[index].Segment);
+			next = 0;
+			double churned = NanosecondsPerCall(count, [&] {
+				Range& range = ranges[random() % (count / 2)];
+				block.Free(range.Segment, range.Size);
+				range.Size = sizes[next++];
+				allocated &= block.Allocate(range.Size, 256, range.Offset, range.Segment);
+			});
+			if (!allocated) {
+				std::cout << "The " << name << " block ran out of space while churning." << std::endl;
+				return false;
+			}
+			std::cout << name << ": allocate " << allocate << " ns, free " << release << " ns, free + allocate "
+					  << churned << " ns per call" << std::endl;
+			return true;
+		}
+	}
+
+	//Needs no device: MemoryBlock only does the bookkeeping.
+	bool RunAllocatorBenchmark() {
+		if (!CheckSmallAllocations())
+			return false;
+		//Linear blocks never reuse a range until they are empty, so they are only timed without churn.
+		return TimeAllocations(PoolStrategy::Tlsf, "TLSF block", 100000, true) &&
+			   TimeAllocations(PoolStrategy::Linear, "Linear block", 100000, false);
+	}
+}
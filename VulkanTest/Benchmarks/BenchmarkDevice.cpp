@@ -0,0 +1,58 @@
+#include "Benchmarks.h"
+namespace VulkanCookbook {
+	bool BenchmarkDevice::Create() {
+		if (!vkapp::loadVulkanLibrary(Library))
+			return false;
+		VkApplicationInfo applicationInfo = {
+			VK_STRUCTURE_TYPE_APPLICATION_INFO,	//sType
+			nullptr,							//pNext
+			"Benchmarks",						//pApplicationName
+			VK_MAKE_VERSION(1, 0, 0),			//applicationVersion
+			"My engine",						//pEngineName
+			VK_MAKE_VERSION(1, 0, 0),			//engineVersion
+			VK_MAKE_VERSION(1, 0, 0)			//apiVersion
+		};
+		VkInstanceCreateInfo instanceCreateInfo = {
+			VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,	//sType
+			nullptr,								//pNext
+			0,										//flags
+			&applicationInfo,						//pApplicationInfo
+			0,										//enabledLayerCount
+			nullptr,								//ppEnabledLayerNames
+			0,										//enabledExtensionsCount
+			nullptr									//ppEnabledExtensionsNames
+		};
+		if (!vkapp::createVulkanInstance(instanceCreateInfo, nullptr, Instance)) {
+			Destroy();
+			return false;
+		}
+
+		std::vector<DeviceScore> ranking;
+		if (!vkapp::rankPhysicalDevices(Instance.Handle, DefaultDeviceRankingPolicy(DeviceRequirements()), ranking) ||
+			!ranking.front().Suitable) {
+			std::cout << "Could not find a physical device to run the benchmarks on." << std::endl;
+			Destroy();
+			return false;
+		}
+		PhysicalDevice = ranking.front().Device;
+
+		QueuePlan plan;
+		std::vector<const char*> extensions;
+		if (!vkapp::planQueues(PhysicalDevice->Handle(), VK_NULL_HANDLE,
+							   WorkloadBit(QueueWorkload::Graphics) | WorkloadBit(QueueWorkload::Transfer), plan) ||
+			!vkapp::createLogicalDeviceWithQueuePlan(PhysicalDevice->Handle(), plan, extensions, nullptr, Device, Queues) ||
+			!vkapp::loadDeviceLevelFunctions(Device.Handle, extensions)) {
+			Destroy();
+			return false;
+		}
+		return true;
+	}
+
+	void BenchmarkDevice::Destroy() {
+		vkapp::destroyLogicalDevice(Device);
+		vkapp::destroyInstance(Instance);
+		vkapp::releaseVulkanLoaderLibrary(Library);
+		PhysicalDevice = nullptr;
+		Queues = {};
+	}
+}
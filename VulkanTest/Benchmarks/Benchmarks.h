@@ -0,0 +1,33 @@
+#pragma once
+#include "vkapp.h"
+namespace VulkanCookbook {
+	//A headless instance and device on the best ranked physical device, with a graphics queue and the
+	//transfer queue the planner picks. Device-level functions are loaded both into the device's table
+	//and into the globals, so that benchmarks can compare the two.
+	struct BenchmarkDevice {
+		LIBRARY_TYPE			  Library		 = nullptr;
+		VulkanInstance			  Instance;
+		const PhysicalDeviceInfo* PhysicalDevice = nullptr;
+		LogicalDevice			  Device;
+		QueueMap				  Queues;
+
+		bool Create();
+		void Destroy();
+	};
+
+	//Mean duration of one of iterations calls, in nanoseconds.
+	template<typename Call>
+	double NanosecondsPerCall(uint32_t iterations, Call call) {
+		Milliseconds elapsed;
+		{
+			ScopedTimer timer(elapsed);
+			for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+				call();
+		}
+		return elapsed.count() * 1e6 / iterations;
+	}
+
+	bool RunAllocatorBenchmark();
+	bool RunDispatchBenchmark(const BenchmarkDevice& device);
+	bool RunUploadBenchmark(const BenchmarkDevice& device);
+}
@@ -0,0 +1,48 @@
+#include "Benchmarks.h"
+namespace VulkanCookbook {
+	//Times the same cheap device-level calls through the device's table, through the globals and through
+	//pointers from vkGetInstanceProcAddr. The table and the globals both come from vkGetDeviceProcAddr, so
+	//they should match; the instance-level pointers are the loader's trampolines, which look the device's
+	//dispatch table up on every call, the way calls to the loader's exports do.
+	bool RunDispatchBenchmark(const BenchmarkDevice& device) {
+		const uint32_t iterations = 1000000;
+		const DeviceDispatchTable& table = device.Device.Dispatch;
+		VkDevice logicalDevice = device.Device.Handle;
+		uint32_t familyIndex = device.Queues.FamilyIndex(QueueWorkload::Graphics);
+
+		auto trampolineGetDeviceQueue = (PFN_vkGetDeviceQueue)vkGetInstanceProcAddr(device.Instance.Handle, "vkGetDeviceQueue");
+		auto trampolineGetFenceStatus = (PFN_vkGetFenceStatus)vkGetInstanceProcAddr(device.Instance.Handle, "vkGetFenceStatus");
+		if (!trampolineGetDeviceQueue || !trampolineGetFenceStatus) {
+			std::cout << "Could not load the loader's trampolines." << std::endl;
+			return false;
+		}
+		VkFenceCreateInfo fenceInfo = {
+			VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,	//sType
+			nullptr,								//pNext
+			0										//flags
+		};
+		VkFence fence;
+		if (table.vkCreateFence(logicalDevice, &fenceInfo, device.Device.HostCallbacks, &fence) != VK_SUCCESS) {
+			std::cout << "Could not create a fence for the dispatch benchmark." << std::endl;
+			return false;
+		}
+
+		auto report = [](const char* function, double throughTable, double throughGlobals, double throughTrampoline) {
+			std::cout << function << ": table " << throughTable << " ns, globals " << throughGlobals
+					  << " ns, loader trampoline " << throughTrampoline << " ns per call" << std::endl;
+		};
+		VkQueue queue;
+		double throughTable = NanosecondsPerCall(iterations, [&] { table.vkGetDeviceQueue(logicalDevice, familyIndex, 0, &queue); });
+		double throughGlobals = NanosecondsPerCall(iterations, [&] { vkGetDeviceQueue(logicalDevice, familyIndex, 0, &queue); });
+		double throughTrampoline = NanosecondsPerCall(iterations, [&] { trampolineGetDeviceQueue(logicalDevice, familyIndex, 0, &queue); });
+		report("vkGetDeviceQueue", throughTable, throughGlobals, throughTrampoline);
+
+		throughTable = NanosecondsPerCall(iterations, [&] { table.vkGetFenceStatus(logicalDevice, fence); });
+		throughGlobals = NanosecondsPerCall(iterations, [&] { vkGetFenceStatus(logicalDevice, fence); });
+		throughTrampoline = NanosecondsPerCall(iterations, [&] { trampolineGetFenceStatus(logicalDevice, fence); });
+		report("vkGetFenceStatus", throughTable, throughGlobals, throughTrampoline);
+
+		table.vkDestroyFence(logicalDevice, fence, device.Device.HostCallbacks);
+		return true;
+	}
+}
@@ -0,0 +1,15 @@
+#include "Benchmarks.h"
+using namespace VulkanCookbook;
+
+int main() {
+	if (!RunAllocatorBenchmark())
+		return 1;
+	BenchmarkDevice device;
+	if (!device.Create()) {
+		std::cout << "Could not create a Vulkan device, skipping the benchmarks that need one." << std::endl;
+		return 0;
+	}
+	bool passed = RunDispatchBenchmark(device) && RunUploadBenchmark(device);
+	device.Destroy();
+	return passed ? 0 : 1;
+}
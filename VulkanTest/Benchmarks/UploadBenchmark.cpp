@@ -0,0 +1,100 @@
+#include "Benchmarks.h"
+#include "StagingHeap.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	namespace {
+		bool HasHostVisibleDeviceLocalMemory(const PhysicalDeviceInfo& device) {
+			const VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			auto& properties = device.MemoryProperties();
+			for (uint32_t type = 0; type < properties.memoryTypeCount; ++type)
+				if ((properties.memoryTypes[type].propertyFlags & flags) == flags)
+					return true;
+			return false;
+		}
+
+		bool CreateDestination(DeviceMemoryAllocator& allocator, VkDeviceSize size, bool hostVisible, VkBuffer& buffer, Allocation& allocation) {
+			VkBufferCreateInfo bufferInfo = {
+				VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,									//sType
+				nullptr,																//pNext
+				0,																		//flags
+				size,																	//size
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,	//usage
+				VK_SHARING_MODE_EXCLUSIVE,												//sharingMode
+				0,																		//queueFamilyIndexCount
+				nullptr																	//pQueueFamilyIndices
+			};
+			AllocationCreateInfo allocationInfo;
+			allocationInfo.RequiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			if (hostVisible)
+				allocationInfo.RequiredFlags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			else
+				allocationInfo.AvoidedFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			allocationInfo.Category = MemoryCategory::Geometry;
+			return allocator.CreateBuffer(bufferInfo, allocationInfo, buffer, allocation);
+		}
+	}
+
+	//Uploads the same data into a device-local buffer through the staging heap, waiting for the copy each
+	//time, and into a host-visible device-local buffer with the direct-write UploadToBuffer overload.
+	//Devices without host-visible device-local memory only run the staged path.
+	bool RunUploadBenchmark(const BenchmarkDevice& device) {
+		DeviceMemoryAllocator allocator(device.Device, *device.PhysicalDevice);
+		TransferContext transfers;
+		StagingHeap staging;
+		if (!transfers.Create(device.Device, device.Queues.Get(QueueWorkload::Transfer), device.Queues.FamilyIndex(QueueWorkload::Transfer)) ||
+			!staging.Create(allocator, transfers, 32 * 1024 * 1024)) {
+			transfers.Destroy();
+			return false;
+		}
+		bool direct = HasHostVisibleDeviceLocalMemory(*device.PhysicalDevice);
+		if (!direct)
+			std::cout << "No host-visible device-local memory type, only the staged upload is timed." << std::endl;
+
+		bool passed = true;
+		for (VkDeviceSize size : { 64ull * 1024, 1024ull * 1024, 16ull * 1024 * 1024 }) {
+			const uint32_t iterations = static_cast<uint32_t>(std::max<VkDeviceSize>(4, 256ull * 1024 * 1024 / size / 4));
+			std::vector<char> data(static_cast<size_t>(size), 1);
+			auto report = [size](const char* path, double nanoseconds) {
+				std::cout << size / 1024 << " KiB " << path << ": " << nanoseconds / 1e6 << " ms per upload ("
+						  << size / nanoseconds << " GB/s)" << std::endl;
+			};
+
+			VkBuffer buffer = VK_NULL_HANDLE;
+			Allocation allocation;
+			if (!CreateDestination(allocator, size, false, buffer, allocation)) {
+				passed = false;
+				break;
+			}
+			bool uploaded = true;
+			double staged = NanosecondsPerCall(iterations, [&] {
+				uploaded &= staging.UploadToBuffer(data.data(), size, buffer) && staging.WaitIdle();
+			});
+			allocator.DestroyBuffer(buffer, allocation);
+			if (!uploaded) {
+				passed = false;
+				break;
+			}
+			report("staged", staged);
+
+			if (!direct)
+				continue;
+			if (!CreateDestination(allocator, size, true, buffer, allocation)) {
+				passed = false;
+				break;
+			}
+			double written = NanosecondsPerCall(iterations, [&] {
+				uploaded &= staging.UploadToBuffer(data.data(), size, buffer, allocation);
+			});
+			allocator.DestroyBuffer(buffer, allocation);
+			if (!uploaded) {
+				passed = false;
+				break;
+			}
+			report("direct", written);
+		}
+
+		staging.Destroy();
+		transfers.Destroy();
+		return passed;
+	}
+}
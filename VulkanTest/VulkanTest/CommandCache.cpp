@@ -0,0 +1,153 @@
+#include "CommandCache.h"
+namespace VulkanCookbook {
+	bool CommandCache::Create(const LogicalDevice& device, uint32_t queueFamilyIndex, ParallelCommandRecorder& recorder, JobSystem& jobs,
+		FrameTimeline& timeline) {
+		Device = &device;
+		Recorder = &recorder;
+		Timeline = &timeline;
+		Statistics = {};
+		Pools.resize(jobs.ThreadCount());
+
+		//buffers are recorded again one at a time, whenever their key changes
+		VkCommandPoolCreateInfo poolInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,			//sType
+			nullptr,											//pNext
+			VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,	//flags
+			queueFamilyIndex									//queueFamilyIndex
+		};
+		for (auto& pool : Pools)
+			if (device.Dispatch.vkCreateCommandPool(device.Handle, &poolInfo, device.HostCallbacks, &pool.Pool) != VK_SUCCESS) {
+				std::cout << "Could not create a command cache pool." << std::endl;
+				Destroy();
+				return false;
+			}
+		return true;
+	}
+
+	void CommandCache::Destroy() {
+		if (!Device)
+			return;
+		for (auto& pool : Pools)
+			if (pool.Pool)
+				Device->Dispatch.vkDestroyCommandPool(Device->Handle, pool.Pool, Device->HostCallbacks);
+		Pools.clear();
+		Entries.clear();
+		RetiredBuffers.clear();
+		Device = nullptr;
+		Recorder = nullptr;
+		Timeline = nullptr;
+	}
+
+	bool CommandCache::Execute(VkCommandBuffer primary, uint64_t key, uint64_t version, VkRenderPass renderPass, uint32_t subpass,
+		VkFramebuffer framebuffer, uint32_t drawCount, const SliceRecorder& recordSlice) {
+		Recycle();
+		Entry& entry = Entries[key];
+		if (entry.Recorded && entry.Version == version && entry.RenderPass == renderPass && entry.Subpass == subpass &&
+			entry.Framebuffer == framebuffer && entry.DrawCount == drawCount)
+			++Statistics.Hits;
+		else {
+			if (!entry.Owned.empty())
+				RetiredBuffers.push_back({ std::move(entry.Owned), entry.LastFrame });
+			entry = {};
+			auto acquire = [this](uint32_t threadIndex) { return Acquire(threadIndex); };
+			bool recorded = Recorder->RecordSlices(renderPass, subpass, framebuffer, drawCount, recordSlice,
+				VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT, acquire, entry.Buffers);
+			entry.Owned = CollectHanded(recorded);
+			if (!recorded) {
+				Entries.erase(key);
+				return false;
+			}
+			entry.Recorded = true;
+			entry.Version = version;
+			entry.RenderPass = renderPass;
+			entry.Subpass = subpass;
+			entry.Framebuffer = framebuffer;
+			entry.DrawCount = drawCount;
+			++Statistics.Misses;
+			Statistics.RecordTime = Recorder->Stats().RecordTime;
+		}
+		entry.LastFrame = Timeline->CurrentFrame();
+		if (!entry.Buffers.empty())
+			Device->Dispatch.vkCmdExecuteCommands(primary, static_cast<uint32_t>(entry.Buffers.size()), entry.Buffers.data());
+		return true;
+	}
+
+	void CommandCache::Clear() {
+		if (!Device)
+			return;
+		for (auto& pool : Pools) {
+			if (Device->Dispatch.vkResetCommandPool(Device->Handle, pool.Pool, 0) != VK_SUCCESS)
+				std::cout << "Could not reset a command cache pool." << std::endl;
+			pool.Free = pool.Buffers;
+		}
+		Entries.clear();
+		RetiredBuffers.clear();
+	}
+
+	CommandCacheStats CommandCache::Stats() const {
+		CommandCacheStats stats = Statistics;
+		stats.AllocatedBuffers = 0;
+		for (const auto& pool : Pools)
+			stats.AllocatedBuffers += static_cast<uint32_t>(pool.Buffers.size());
+		return stats;
+	}
+
+	//Runs on the job thread threadIndex, which is the only one using its pool meanwhile.
+	VkCommandBuffer CommandCache::Acquire(uint32_t threadIndex) {
+		ThreadPool& pool = Pools[threadIndex];
+		VkCommandBuffer commandBuffer;
+		if (!pool.Free.empty()) {
+			//vkBeginCommandBuffer resets it
+			commandBuffer = pool.Free.back();
+			pool.Free.pop_back();
+		} else {
+			VkCommandBufferAllocateInfo allocateInfo = {
+				VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,	//sType
+				nullptr,										//pNext
+				pool.Pool,										//commandPool
+				VK_COMMAND_BUFFER_LEVEL_SECONDARY,				//level
+				1												//commandBufferCount
+			};
+			if (Device->Dispatch.vkAllocateCommandBuffers(Device->Handle, &allocateInfo, &commandBuffer) != VK_SUCCESS) {
+				std::cout << "Could not allocate a cached command buffer." << std::endl;
+				return VK_NULL_HANDLE;
+			}
+			pool.Buffers.push_back(commandBuffer);
+		}
+		pool.Handed.push_back(commandBuffer);
+		return commandBuffer;
+	}
+
+	std::vector<CommandCache::CachedBuffer> CommandCache::CollectHanded(bool keep) {
+		std::vector<CachedBuffer> handed;
+		for (uint32_t index = 0; index < Pools.size(); ++index) {
+			ThreadPool& pool = Pools[index];
+			for (auto commandBuffer : pool.Handed)
+				if (keep)
+					handed.push_back({ commandBuffer, index });
+				else
+					pool.Free.push_back(commandBuffer);
+			pool.Handed.clear();
+		}
+		return handed;
+	}
+
+	void CommandCache::Recycle() {
+		if (RetiredBuffers.empty())
+			return;
+		uint64_t completed = Timeline->CompletedFrame();
+		size_t kept = 0;
+		for (size_t index = 0; index < RetiredBuffers.size(); ++index) {
+			Retired& retired = RetiredBuffers[index];
+			if (retired.Frame > completed) {
+				if (kept != index)
+					RetiredBuffers[kept] = std::move(retired);
+				++kept;
+				continue;
+			}
+			for (const auto& cached : retired.Buffers)
+				Pools[cached.Pool].Free.push_back(cached.Buffer);
+		}
+		RetiredBuffers.resize(kept);
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "Common.h"
+#include "ParallelCommandRecorder.h"
+#include "FrameTimeline.h"
+namespace VulkanCookbook {
+	struct CommandCacheStats {
+		uint64_t	 Hits			  = 0;	//Execute calls that reused their secondary command buffers
+		uint64_t	 Misses			  = 0;	//Execute calls that recorded them again
+		uint32_t	 AllocatedBuffers = 0;	//over all pools; stays flat once the cache has been through its peak
+		Milliseconds RecordTime{};			//of the last miss
+	};
+
+	//Keeps the secondary command buffers recorded for a key, such as a pass and a swapchain image, and
+	//executes them again as long as the caller passes the same version: a hash of everything the
+	//recording reads, like pipeline, buffer and descriptor set handles and the draw list. Only a key
+	//whose version, render pass, subpass, framebuffer or draw count changed is recorded again, by a
+	//ParallelCommandRecorder into buffers from one pool per job thread. Buffers are recorded with
+	//SIMULTANEOUS_USE, since several frames in flight may execute them, and replaced buffers are kept
+	//until the frame that last executed them is complete before they are recorded again.
+	//Push constants, dynamic state and anything else that changes every frame belongs in the primary
+	//command buffer or in buffers that are read at execution time, not in a cached recording.
+	class CommandCache {
+	 public:
+		bool Create(const LogicalDevice& device, uint32_t queueFamilyIndex, ParallelCommandRecorder& recorder, JobSystem& jobs,
+			FrameTimeline& timeline);
+		void Destroy();
+
+		//primary must have begun the subpass with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS and be
+		//submitted as the timeline's current frame.
+		bool Execute(VkCommandBuffer primary, uint64_t key, uint64_t version, VkRenderPass renderPass, uint32_t subpass,
+			VkFramebuffer framebuffer, uint32_t drawCount, const SliceRecorder& recordSlice);
+		//Forgets every recording. The GPU must be done with all of them, e.g. after vkDeviceWaitIdle when
+		//the render passes or framebuffers they continue are destroyed.
+		void Clear();
+
+		CommandCacheStats Stats() const;
+	 private:
+		struct CachedBuffer {
+			VkCommandBuffer Buffer = VK_NULL_HANDLE;
+			uint32_t		Pool   = 0;
+		};
+		struct ThreadPool {
+			VkCommandPool				 Pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> Buffers;	//all allocated from Pool
+			std::vector<VkCommandBuffer> Free;
+			std::vector<VkCommandBuffer> Handed;	//by the recording in progress
+		};
+		struct Entry {
+			bool						 Recorded	 = false;
+			uint64_t					 Version	 = 0;
+			VkRenderPass				 RenderPass	 = VK_NULL_HANDLE;
+			uint32_t					 Subpass	 = 0;
+			VkFramebuffer				 Framebuffer = VK_NULL_HANDLE;
+			uint32_t					 DrawCount	 = 0;
+			std::vector<VkCommandBuffer> Buffers;	//in execution order
+			std::vector<CachedBuffer>	 Owned;
+			uint64_t					 LastFrame	 = 0;	//the last frame that executed Buffers
+		};
+		struct Retired {
+			std::vector<CachedBuffer> Buffers;
+			uint64_t				  Frame = 0;
+		};
+
+		VkCommandBuffer Acquire(uint32_t threadIndex);
+		//Takes the buffers of the recording in progress back from Handed; they go to Free unless keep.
+		std::vector<CachedBuffer> CollectHanded(bool keep);
+		//Returns the buffers of complete frames to their pools.
+		void Recycle();
+
+		const LogicalDevice*				 Device	  = nullptr;
+		ParallelCommandRecorder*			 Recorder = nullptr;
+		FrameTimeline*						 Timeline = nullptr;
+		std::vector<ThreadPool>				 Pools;	//one per job thread
+		std::unordered_map<uint64_t, Entry>	 Entries;
+		std::vector<Retired>				 RetiredBuffers;
+		CommandCacheStats					 Statistics;
+	};
+}
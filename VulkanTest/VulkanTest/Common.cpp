@@ -1,9 +1,50 @@
 #include "Common.h"
 namespace VulkanCookbook {
-	bool IsExtensionSupported(const std::vector<VkExtensionProperties>& availableExtensions,
-							  const char* const extension) {
-		return (std::find_if(availableExtensions.cbegin(), availableExtensions.cend(), 
-				[&extension](const VkExtensionProperties& e)
-				{return strstr(e.extensionName, extension) != nullptr; }) != availableExtensions.end());
+	bool IsExtensionSupported(const ExtensionSet& availableExtensions, const char* const extension) {
+		return availableExtensions.Contains(extension);
+	}
+
+	ExtensionSet::ExtensionSet(const std::vector<const char*>& extensions) {
+		Reserve(extensions.size());
+		for (auto& extension : extensions)
+			Insert(extension);
+	}
+
+	ExtensionSet::ExtensionSet(const std::vector<VkExtensionProperties>& extensions) {
+		Reserve(extensions.size());
+		for (auto& extension : extensions)
+			Insert(extension.extensionName);
+	}
+
+	void ExtensionSet::Reserve(size_t count) {
+		size_t capacity = 4;
+		while (capacity < count * 2)
+			capacity <<= 1;
+		Names.reserve(count);
+		Hashes.reserve(count);
+		Slots.assign(capacity, 0);
+		Mask = capacity - 1;
+	}
+
+	void ExtensionSet::Insert(const char* extension) {
+		uint64_t hash = HashExtensionName(extension);
+		uint64_t slot = hash & Mask;
+		for (; Slots[slot] != 0; slot = (slot + 1) & Mask)
+			if (Hashes[Slots[slot] - 1] == hash && Names[Slots[slot] - 1] == extension)
+				return;
+		Names.emplace_back(extension);
+		Hashes.push_back(hash);
+		Slots[slot] = static_cast<uint32_t>(Names.size());
+	}
+
+	bool ExtensionSet::Contains(uint64_t extensionHash, const char* extension) const {
+		if (Slots.empty())
+			return false;
+		for (uint64_t slot = extensionHash & Mask; Slots[slot] != 0; slot = (slot + 1) & Mask) {
+			uint32_t index = Slots[slot] - 1;
+			if (Hashes[index] == extensionHash && strcmp(Names[index].c_str(), extension) == 0)
+				return true;
+		}
+		return false;
 	}
 }
\ No newline at end of file
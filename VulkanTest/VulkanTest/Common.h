@@ -15,6 +15,9 @@
 #include <cmath>
 #include <functional>
 #include <memory>
+#include <chrono>
+#include <optional>
+#include <unordered_map>
 #include "VulkanFunctions.h"
 namespace VulkanCookbook {
 #ifdef _WIN32
@@ -36,7 +39,71 @@ namespace VulkanCookbook {
 		#endif
 	};
 
+	struct VulkanInstance {
+		VkInstance					 Handle		   = VK_NULL_HANDLE;
+		InstanceDispatchTable		 Dispatch;
+		const VkAllocationCallbacks* HostCallbacks = nullptr;	//for every create and destroy of the instance's objects
+	};
+
+	struct LogicalDevice {
+		VkPhysicalDevice			 PhysicalDevice = VK_NULL_HANDLE;
+		VkDevice					 Handle			= VK_NULL_HANDLE;
+		DeviceDispatchTable			 Dispatch;
+		const VkAllocationCallbacks* HostCallbacks	= nullptr;	//for every create and destroy of the device's objects
+	};
+
+	//FNV-1a; constexpr so that the names listed in ListOfVulkanFunctions.inl hash at compile time.
+	constexpr uint64_t HashExtensionName(const char* name) {
+		uint64_t hash = 14695981039346656037ull;
+		for (; *name != '\0'; ++name)
+			hash = (hash ^ static_cast<uint8_t>(*name)) * 1099511628211ull;
+		return hash;
+	}
+
+	//Folds value into hash the same way, a byte at a time; for versions built from the handles and
+	//counters that some recorded work depends on.
+	constexpr uint64_t HashCombine(uint64_t hash, uint64_t value) {
+		for (int byte = 0; byte < 8; ++byte, value >>= 8)
+			hash = (hash ^ (value & 0xff)) * 1099511628211ull;
+		return hash;
+	}
+	//Non-dispatchable handles are pointers on 64-bit platforms and uint64_t elsewhere.
+	template<typename Handle>
+	uint64_t HashCombine(uint64_t hash, Handle* handle) {
+		return HashCombine(hash, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(handle)));
+	}
+
+	//Extension names in an open-addressing table keyed by their hash. A hit is confirmed
+	//with strcmp, so lookups are exact (unlike a substring search) and take one probe sequence.
+	class ExtensionSet {
+	 public:
+		ExtensionSet() = default;
+		explicit ExtensionSet(const std::vector<const char*>& extensions);
+		explicit ExtensionSet(const std::vector<VkExtensionProperties>& extensions);
 
-	bool IsExtensionSupported(const std::vector<VkExtensionProperties>&,
-							  const char* const);
+		bool Contains(const char* extension) const { return Contains(HashExtensionName(extension), extension); }
+		bool Contains(uint64_t extensionHash, const char* extension) const;
+		size_t Size() const { return Names.size(); }
+	 private:
+		void Reserve(size_t count);
+		void Insert(const char* extension);
+
+		std::vector<std::string> Names;
+		std::vector<uint64_t>	 Hashes;
+		std::vector<uint32_t>	 Slots;	//index into Names + 1, 0 marks an empty slot
+		uint64_t				 Mask = 0;
+	};
+
+	bool IsExtensionSupported(const ExtensionSet&, const char* const);
+
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+
+	class ScopedTimer {
+	 public:
+		explicit ScopedTimer(Milliseconds& elapsed) : Elapsed(elapsed), Start(std::chrono::steady_clock::now()) {}
+		~ScopedTimer() { Elapsed = std::chrono::steady_clock::now() - Start; }
+	 private:
+		Milliseconds&						  Elapsed;
+		std::chrono::steady_clock::time_point Start;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "DeviceSelection.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	namespace {
+		constexpr size_t FeatureCount = sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32);
+
+		//VkPhysicalDeviceFeatures is nothing but VkBool32 members, so it can be walked as an array.
+		const VkBool32* FeatureArray(const VkPhysicalDeviceFeatures& features) {
+			return reinterpret_cast<const VkBool32*>(&features);
+		}
+	}
+
+	void DeviceScore::Add(std::string name, int64_t points) {
+		Total += points;
+		Breakdown.push_back({ std::move(name), points });
+	}
+
+	void DeviceScore::Reject(std::string reason) {
+		Suitable = false;
+		if (RejectionReason.empty())
+			RejectionReason = std::move(reason);
+		else
+			RejectionReason += "; " + reason;
+	}
+
+	DefaultDeviceRankingPolicy::DefaultDeviceRankingPolicy(DeviceRequirements requirements, DeviceRankingWeights weights)
+		: Requirements(std::move(requirements)), Weights(weights) {
+	}
+
+	DeviceScore DefaultDeviceRankingPolicy::Score(const PhysicalDeviceInfo& device) const {
+		DeviceScore score;
+		score.Device = &device;
+		auto& properties = device.Properties();
+
+		if (properties.apiVersion < Requirements.MinApiVersion)
+			score.Reject("API version too old");
+		for (auto& extension : Requirements.RequiredExtensions)
+			if (!device.Extensions().Contains(extension))
+				score.Reject(std::string("missing extension ") + extension);
+
+		const VkBool32* required  = FeatureArray(Requirements.RequiredFeatures);
+		const VkBool32* optional  = FeatureArray(Requirements.OptionalFeatures);
+		const VkBool32* supported = FeatureArray(device.Features());
+		uint32_t missingFeatures = 0, optionalFeatures = 0;
+		for (size_t feature = 0; feature < FeatureCount; ++feature) {
+			if (required[feature] && !supported[feature])
+				++missingFeatures;
+			if (optional[feature] && supported[feature])
+				++optionalFeatures;
+		}
+		if (missingFeatures > 0)
+			score.Reject("missing " + std::to_string(missingFeatures) + " required feature(s)");
+
+		bool hasRequiredQueues = false, hasDedicatedTransfer = false, hasDedicatedCompute = false;
+		for (auto& family : device.QueueFamilies()) {
+			if (family.queueCount == 0)
+				continue;
+			if ((family.queueFlags & Requirements.RequiredQueueFlags) == Requirements.RequiredQueueFlags)
+				hasRequiredQueues = true;
+			if ((family.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+				!(family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+				hasDedicatedTransfer = true;
+			if ((family.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(family.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+				hasDedicatedCompute = true;
+		}
+		if (!hasRequiredQueues)
+			score.Reject("no queue family with the required capabilities");
+
+		switch (properties.deviceType) {
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:	 score.Add("discrete GPU", Weights.DiscreteGpu); break;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score.Add("integrated GPU", Weights.IntegratedGpu); break;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:	 score.Add("virtual GPU", Weights.VirtualGpu); break;
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:			 score.Add("CPU", Weights.Cpu); break;
+		default:									 break;
+		}
+
+		const VkDeviceSize mib = 1024 * 1024;
+		VkDeviceSize deviceLocalMiB = device.DeviceLocalHeapSize() / mib;
+		score.Add("device-local memory (" + std::to_string(deviceLocalMiB) + " MiB)",
+				  static_cast<int64_t>(deviceLocalMiB) * Weights.PointsPerDeviceLocalGiB / 1024);
+		if (hasDedicatedTransfer)
+			score.Add("dedicated transfer family", Weights.DedicatedTransferFamily);
+		if (hasDedicatedCompute)
+			score.Add("dedicated compute family", Weights.DedicatedComputeFamily);
+		if (optionalFeatures > 0)
+			score.Add(std::to_string(optionalFeatures) + " optional feature(s)", optionalFeatures * Weights.PerOptionalFeature);
+		score.Add("maxImageDimension2D " + std::to_string(device.Limits().maxImageDimension2D),
+				  device.Limits().maxImageDimension2D / 1024 * Weights.PerMaxImageDimension1024);
+		VkSampleCountFlagBits samples = device.MaxUsableSampleCount();
+		score.Add("max MSAA x" + std::to_string(samples), samples * Weights.PerMsaaSampleCount);
+		return score;
+	}
+
+	std::vector<DeviceScore> RankPhysicalDevices(const std::vector<const PhysicalDeviceInfo*>& devices,
+												 const DeviceRankingPolicy& policy) {
+		std::vector<DeviceScore> scores;
+		scores.reserve(devices.size());
+		for (auto device : devices)
+			scores.push_back(policy.Score(*device));
+		std::stable_sort(scores.begin(), scores.end(), [](const DeviceScore& a, const DeviceScore& b) {
+			if (a.Suitable != b.Suitable)
+				return a.Suitable;
+			return a.Total > b.Total;
+		});
+		return scores;
+	}
+
+	void PrintDeviceScore(const DeviceScore& score, std::ostream& stream) {
+		stream << score.Device->Properties().deviceName << ": ";
+		if (!score.Suitable) {
+			stream << "rejected (" << score.RejectionReason << ")" << std::endl;
+			return;
+		}
+		stream << score.Total << std::endl;
+		for (auto& term : score.Breakdown)
+			stream << "    " << term.Name << ": " << term.Points << std::endl;
+	}
+}
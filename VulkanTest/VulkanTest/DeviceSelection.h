@@ -0,0 +1,63 @@
+#pragma once
+#include "PhysicalDeviceInfo.h"
+namespace VulkanCookbook {
+	struct ScoreTerm {
+		std::string Name;
+		int64_t		Points;
+	};
+
+	//Result of scoring one device; Breakdown lists every term that went into Total.
+	struct DeviceScore {
+		const PhysicalDeviceInfo* Device   = nullptr;
+		bool					  Suitable = true;
+		std::string				  RejectionReason;
+		int64_t					  Total	   = 0;
+		std::vector<ScoreTerm>	  Breakdown;
+
+		void Add(std::string name, int64_t points);
+		void Reject(std::string reason);
+	};
+
+	class DeviceRankingPolicy {
+	 public:
+		virtual ~DeviceRankingPolicy() = default;
+		virtual DeviceScore Score(const PhysicalDeviceInfo& device) const = 0;
+	};
+
+	struct DeviceRequirements {
+		VkPhysicalDeviceFeatures RequiredFeatures	= {};
+		VkPhysicalDeviceFeatures OptionalFeatures	= {};
+		std::vector<const char*> RequiredExtensions;
+		VkQueueFlags			 RequiredQueueFlags = VK_QUEUE_GRAPHICS_BIT;
+		uint32_t				 MinApiVersion		= VK_MAKE_VERSION(1, 0, 0);
+	};
+
+	struct DeviceRankingWeights {
+		int64_t DiscreteGpu				 = 10000;
+		int64_t IntegratedGpu			 = 2000;
+		int64_t VirtualGpu				 = 1000;
+		int64_t Cpu						 = 100;
+		int64_t PointsPerDeviceLocalGiB	 = 250;
+		int64_t DedicatedTransferFamily	 = 500;
+		int64_t DedicatedComputeFamily	 = 500;
+		int64_t PerOptionalFeature		 = 100;
+		int64_t PerMaxImageDimension1024 = 10;
+		int64_t PerMsaaSampleCount		 = 10;
+	};
+
+	//Rejects devices that miss a requirement and ranks the rest on device type, device-local
+	//memory, dedicated transfer/compute families, optional features and a few limits.
+	class DefaultDeviceRankingPolicy : public DeviceRankingPolicy {
+	 public:
+		explicit DefaultDeviceRankingPolicy(DeviceRequirements requirements, DeviceRankingWeights weights = {});
+		DeviceScore Score(const PhysicalDeviceInfo& device) const override;
+	 protected:
+		DeviceRequirements	 Requirements;
+		DeviceRankingWeights Weights;
+	};
+
+	//Best first; unsuitable devices are kept at the end so the rejection reasons can be reported.
+	std::vector<DeviceScore> RankPhysicalDevices(const std::vector<const PhysicalDeviceInfo*>& devices,
+												 const DeviceRankingPolicy& policy);
+	void PrintDeviceScore(const DeviceScore& score, std::ostream& stream = std::cout);
+}
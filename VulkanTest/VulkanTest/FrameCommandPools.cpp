@@ -0,0 +1,84 @@
+#include "FrameCommandPools.h"
+namespace VulkanCookbook {
+	bool FrameCommandPools::Create(const LogicalDevice& device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t threadCount) {
+		Device = &device;
+		Frames = framesInFlight;
+		Threads = threadCount;
+		CurrentFrame = 0;
+		Pools.resize(static_cast<size_t>(framesInFlight) * threadCount);
+
+		//no RESET_COMMAND_BUFFER_BIT: buffers are only ever reset together with their pool
+		VkCommandPoolCreateInfo poolInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,	//sType
+			nullptr,									//pNext
+			VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,		//flags
+			queueFamilyIndex							//queueFamilyIndex
+		};
+		for (auto& pool : Pools)
+			if (device.Dispatch.vkCreateCommandPool(device.Handle, &poolInfo, device.HostCallbacks, &pool.Pool) != VK_SUCCESS) {
+				std::cout << "Could not create a frame command pool." << std::endl;
+				Destroy();
+				return false;
+			}
+		return true;
+	}
+
+	void FrameCommandPools::Destroy() {
+		if (!Device)
+			return;
+		//destroying a pool frees its command buffers
+		for (auto& pool : Pools)
+			if (pool.Pool)
+				Device->Dispatch.vkDestroyCommandPool(Device->Handle, pool.Pool, Device->HostCallbacks);
+		Pools.clear();
+		Device = nullptr;
+	}
+
+	bool FrameCommandPools::BeginFrame(uint32_t frameIndex) {
+		CurrentFrame = frameIndex;
+		for (uint32_t thread = 0; thread < Threads; ++thread) {
+			ThreadPool& pool = Pools[static_cast<size_t>(frameIndex) * Threads + thread];
+			if (pool.Used[0] == 0 && pool.Used[1] == 0)
+				continue;
+			if (Device->Dispatch.vkResetCommandPool(Device->Handle, pool.Pool, 0) != VK_SUCCESS) {
+				std::cout << "Could not reset a frame command pool." << std::endl;
+				return false;
+			}
+			pool.Used[0] = pool.Used[1] = 0;
+		}
+		return true;
+	}
+
+	VkCommandBuffer FrameCommandPools::Acquire(uint32_t threadIndex, VkCommandBufferLevel level) {
+		ThreadPool& pool = Pools[static_cast<size_t>(CurrentFrame) * Threads + threadIndex];
+		std::vector<VkCommandBuffer>& buffers = pool.Buffers[level];
+		size_t& used = pool.Used[level];
+		if (used == buffers.size()) {
+			VkCommandBufferAllocateInfo allocateInfo = {
+				VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,	//sType
+				nullptr,										//pNext
+				pool.Pool,										//commandPool
+				level,											//level
+				1												//commandBufferCount
+			};
+			VkCommandBuffer commandBuffer;
+			if (Device->Dispatch.vkAllocateCommandBuffers(Device->Handle, &allocateInfo, &commandBuffer) != VK_SUCCESS) {
+				std::cout << "Could not allocate a frame command buffer." << std::endl;
+				return VK_NULL_HANDLE;
+			}
+			buffers.push_back(commandBuffer);
+		}
+		return buffers[used++];
+	}
+
+	FrameCommandPoolStats FrameCommandPools::Stats() const {
+		FrameCommandPoolStats stats;
+		for (size_t index = 0; index < Pools.size(); ++index) {
+			const ThreadPool& pool = Pools[index];
+			stats.AllocatedBuffers += static_cast<uint32_t>(pool.Buffers[0].size() + pool.Buffers[1].size());
+			if (index / Threads == CurrentFrame)
+				stats.AcquiredThisFrame += static_cast<uint32_t>(pool.Used[0] + pool.Used[1]);
+		}
+		return stats;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "Common.h"
+namespace VulkanCookbook {
+	struct FrameCommandPoolStats {
+		uint32_t AllocatedBuffers  = 0;	//over all pools; stays flat once every frame has been through its peak
+		uint32_t AcquiredThisFrame = 0;
+	};
+
+	//One TRANSIENT command pool per frame in flight and per recording thread. Command buffers are
+	//recorded every frame: BeginFrame resets all pools of a frame with one vkResetCommandPool each once
+	//its fence has signalled, and Acquire hands the same command buffers out again, allocating only when
+	//a frame needs more than it ever did before. Nothing is freed until Destroy.
+	//A pool, like the command buffers taken from it, may only be used by one thread at a time, so each
+	//recording thread passes its own threadIndex.
+	class FrameCommandPools {
+	 public:
+		bool Create(const LogicalDevice& device, uint32_t queueFamilyIndex, uint32_t framesInFlight, uint32_t threadCount);
+		void Destroy();
+
+		//The GPU must be done with the frame's previous use, i.e. its fence has signalled.
+		bool BeginFrame(uint32_t frameIndex);
+		//A reset command buffer of the current frame; the caller begins and ends it. VK_NULL_HANDLE on failure.
+		VkCommandBuffer Acquire(uint32_t threadIndex, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+		uint32_t ThreadCount() const { return Threads; }
+		FrameCommandPoolStats Stats() const;
+	 private:
+		struct ThreadPool {
+			VkCommandPool				 Pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> Buffers[2];	//indexed by VkCommandBufferLevel
+			size_t						 Used[2] = {};
+		};
+
+		const LogicalDevice*	Device		 = nullptr;
+		uint32_t				Frames		 = 0;
+		uint32_t				Threads		 = 0;
+		uint32_t				CurrentFrame = 0;
+		std::vector<ThreadPool> Pools;	//frame * Threads + thread
+	};
+}
@@ -0,0 +1,185 @@
+#include "FrameTimeline.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	bool FrameTimeline::Create(const LogicalDevice& device, uint32_t framesInFlight, bool timeline) {
+		Device = &device;
+		Frames = framesInFlight;
+		Current = 1;
+		Completed = 0;
+		Statistics = {};
+		SubmitTimes.assign(framesInFlight, {});
+	#ifdef VK_KHR_timeline_semaphore
+		if (timeline) {
+			VkSemaphoreTypeCreateInfoKHR typeInfo = {
+				VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR,	//sType
+				nullptr,											//pNext
+				VK_SEMAPHORE_TYPE_TIMELINE_KHR,						//semaphoreType
+				0													//initialValue
+			};
+			VkSemaphoreCreateInfo semaphoreInfo = {
+				VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,	//sType
+				&typeInfo,									//pNext
+				0											//flags
+			};
+			if (device.Dispatch.vkCreateSemaphore(device.Handle, &semaphoreInfo, device.HostCallbacks, &Timeline) != VK_SUCCESS) {
+				std::cout << "Could not create the frame timeline semaphore." << std::endl;
+				Device = nullptr;
+				return false;
+			}
+			return true;
+		}
+	#else
+		(void)timeline;
+	#endif
+		//unsignalled: a fence that has never been submitted belongs to frame 0, which is complete
+		VkFenceCreateInfo fenceInfo = {
+			VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,	//sType
+			nullptr,								//pNext
+			0										//flags
+		};
+		Fences.assign(framesInFlight, VK_NULL_HANDLE);
+		FenceFrames.assign(framesInFlight, 0);
+		for (auto& fence : Fences)
+			if (device.Dispatch.vkCreateFence(device.Handle, &fenceInfo, device.HostCallbacks, &fence) != VK_SUCCESS) {
+				std::cout << "Could not create a frame fence." << std::endl;
+				Destroy();
+				return false;
+			}
+		return true;
+	}
+
+	void FrameTimeline::Destroy() {
+		if (!Device)
+			return;
+		Wait(Current - 1);
+		if (Timeline)
+			Device->Dispatch.vkDestroySemaphore(Device->Handle, Timeline, Device->HostCallbacks);
+		for (auto fence : Fences)
+			if (fence)
+				Device->Dispatch.vkDestroyFence(Device->Handle, fence, Device->HostCallbacks);
+		Timeline = VK_NULL_HANDLE;
+		Fences.clear();
+		FenceFrames.clear();
+		Device = nullptr;
+	}
+
+	bool FrameTimeline::BeginFrame() {
+		return Current <= Frames || Wait(Current - Frames);
+	}
+
+	bool FrameTimeline::Submit(VkQueue queue, const VkSubmitInfo& submitInfo) {
+		VkSubmitInfo signallingInfo = submitInfo;
+		VkFence fence = VK_NULL_HANDLE;
+	#ifdef VK_KHR_timeline_semaphore
+		VkTimelineSemaphoreSubmitInfoKHR timelineInfo;
+		if (Timeline) {
+			//binary semaphores ignore their values, but every signalled semaphore needs one
+			SignalSemaphores.assign(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+			SignalSemaphores.push_back(Timeline);
+			SignalValues.assign(submitInfo.signalSemaphoreCount, 0);
+			SignalValues.push_back(Current);
+			timelineInfo = {
+				VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR,	//sType
+				submitInfo.pNext,										//pNext
+				0,														//waitSemaphoreValueCount
+				nullptr,												//pWaitSemaphoreValues
+				static_cast<uint32_t>(SignalValues.size()),				//signalSemaphoreValueCount
+				SignalValues.data()										//pSignalSemaphoreValues
+			};
+			signallingInfo.pNext = &timelineInfo;
+			signallingInfo.signalSemaphoreCount = static_cast<uint32_t>(SignalSemaphores.size());
+			signallingInfo.pSignalSemaphores = SignalSemaphores.data();
+		} else
+	#endif
+		{
+			//normally BeginFrame has already waited for the frame that used this fence last
+			uint32_t index = FrameIndex();
+			if (!Wait(FenceFrames[index]))
+				return false;
+			fence = Fences[index];
+			if (Device->Dispatch.vkResetFences(Device->Handle, 1, &fence) != VK_SUCCESS) {
+				std::cout << "Could not reset a frame fence." << std::endl;
+				return false;
+			}
+			FenceFrames[index] = Current;
+		}
+		if (Device->Dispatch.vkQueueSubmit(queue, 1, &signallingInfo, fence) != VK_SUCCESS) {
+			std::cout << "Could not submit frame " << Current << "." << std::endl;
+			return false;
+		}
+		SubmitTimes[FrameIndex()] = std::chrono::steady_clock::now();
+		++Current;
+		++Statistics.Submits;
+		return true;
+	}
+
+	uint64_t FrameTimeline::CompletedFrame() {
+	#ifdef VK_KHR_timeline_semaphore
+		if (Timeline) {
+			uint64_t value;
+			if (Device->Dispatch.vkGetSemaphoreCounterValueKHR(Device->Handle, Timeline, &value) == VK_SUCCESS)
+				Retire(value);
+			return Completed;
+		}
+	#endif
+		//frames finish in submission order, so the first unsignalled fence ends the search
+		for (uint64_t frame = Completed + 1; frame < Current; ++frame) {
+			uint32_t index = static_cast<uint32_t>(frame % Frames);
+			if (FenceFrames[index] != frame || Device->Dispatch.vkGetFenceStatus(Device->Handle, Fences[index]) != VK_SUCCESS)
+				break;
+			Retire(frame);
+		}
+		return Completed;
+	}
+
+	bool FrameTimeline::Wait(uint64_t frame) {
+		if (frame <= Completed)
+			return true;
+		if (frame >= Current) {
+			std::cout << "Frame " << frame << " has not been submitted and would never complete." << std::endl;
+			return false;
+		}
+		++Statistics.HostWaits;
+	#ifdef VK_KHR_timeline_semaphore
+		if (Timeline) {
+			VkSemaphoreWaitInfoKHR waitInfo = {
+				VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR,	//sType
+				nullptr,									//pNext
+				0,											//flags
+				1,											//semaphoreCount
+				&Timeline,									//pSemaphores
+				&frame										//pValues
+			};
+			if (Device->Dispatch.vkWaitSemaphoresKHR(Device->Handle, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+				std::cout << "Could not wait for frame " << frame << "." << std::endl;
+				return false;
+			}
+			Retire(frame);
+			return true;
+		}
+	#endif
+		//the fence may already carry a later frame, which finishes after this one
+		uint32_t index = static_cast<uint32_t>(frame % Frames);
+		if (Device->Dispatch.vkWaitForFences(Device->Handle, 1, &Fences[index], VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+			std::cout << "Could not wait for frame " << frame << "." << std::endl;
+			return false;
+		}
+		Retire(FenceFrames[index]);
+		return true;
+	}
+
+	void FrameTimeline::Retire(uint64_t frame) {
+		auto now = std::chrono::steady_clock::now();
+		for (uint64_t completed = Completed + 1; completed <= frame; ++completed) {
+			//a later frame has taken the slot if BeginFrame was skipped; its time is not this frame's
+			if (completed + Frames < Current)
+				continue;
+			Milliseconds latency = now - SubmitTimes[completed % Frames];
+			++Statistics.MeasuredFrames;
+			Statistics.SubmitToComplete = latency;
+			Statistics.MaxSubmitToComplete = std::max(Statistics.MaxSubmitToComplete, latency);
+			Statistics.AverageSubmitToComplete += (latency - Statistics.AverageSubmitToComplete) / static_cast<double>(Statistics.MeasuredFrames);
+		}
+		Completed = std::max(Completed, frame);
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "Common.h"
+namespace VulkanCookbook {
+	//How far the CPU may run ahead of the display. More frames in flight and swapchain images keep the
+	//GPU busy; fewer shorten the queue a frame waits in between being built and being shown.
+	struct FramePacing {
+		uint32_t FramesInFlight	 = 2;
+		uint32_t SwapchainImages = 0;		//0: one more than the surface's minimum; otherwise clamped to what it allows
+		bool	 JustInTimeInput = false;	//sample input only once the previous frame has finished on the GPU
+
+		static FramePacing Throughput() { return {}; }
+		static FramePacing LowLatency() { return { 1, 1, true }; }
+	};
+
+	struct FrameTimelineStats {
+		uint64_t	 Submits				 = 0;
+		uint64_t	 HostWaits				 = 0;	//waits that Wait had to make on the GPU
+		//From Submit until the frame was seen complete, which is when its image can be presented. A frame
+		//found complete by polling is measured when it was polled, so the figure is an upper bound.
+		Milliseconds SubmitToComplete		 = {};	//of the last frame
+		Milliseconds MaxSubmitToComplete	 = {};
+		Milliseconds AverageSubmitToComplete = {};
+		uint64_t	 MeasuredFrames			 = 0;
+	};
+
+	//Numbers the frames 1, 2, 3, ... A frame is complete once its submission and every earlier one have
+	//finished, so anything used by frame N can be reused or destroyed once IsComplete(N); subsystems keep
+	//the CurrentFrame() they used a resource in instead of a fence of their own.
+	//With VK_KHR_timeline_semaphore the frame numbers are the values of one timeline semaphore: Submit
+	//signals it, and polling or waiting reads it. Without it, one fence per frame in flight stands in,
+	//and a frame is complete once its fence has signalled. Either way all frames go to one queue.
+	class FrameTimeline {
+	 public:
+		//timeline: the device was created with VK_KHR_timeline_semaphore and its timelineSemaphore feature.
+		bool Create(const LogicalDevice& device, uint32_t framesInFlight, bool timeline);
+		//Waits for every submitted frame.
+		void Destroy();
+
+		//Waits until frame CurrentFrame() - framesInFlight is complete, so the current frame may reuse the
+		//per-frame resources at FrameIndex().
+		bool BeginFrame();
+		//The frame being recorded; Submit signals it and moves on to the next one.
+		uint64_t CurrentFrame() const { return Current; }
+		uint32_t FrameIndex() const { return static_cast<uint32_t>(Current % Frames); }
+		//submitInfo may wait for and signal binary semaphores; its fence slot is taken by the fallback.
+		bool Submit(VkQueue queue, const VkSubmitInfo& submitInfo);
+
+		//The last complete frame, 0 before the first one completes. Does not block.
+		uint64_t CompletedFrame();
+		bool IsComplete(uint64_t frame) { return frame <= CompletedFrame(); }
+		bool Wait(uint64_t frame);
+
+		bool UsesTimeline() const { return Timeline != VK_NULL_HANDLE; }
+		const FrameTimelineStats& Stats() const { return Statistics; }
+	 private:
+		//Moves Completed up to frame and measures the frames that completed on the way.
+		void Retire(uint64_t frame);
+
+		const LogicalDevice*	 Device	   = nullptr;
+		uint32_t				 Frames	   = 0;
+		uint64_t				 Current   = 1;
+		uint64_t				 Completed = 0;
+		VkSemaphore				 Timeline  = VK_NULL_HANDLE;
+		std::vector<VkFence>	 Fences;		//the fallback; frame % Frames
+		std::vector<uint64_t>	 FenceFrames;	//the frame each fence was last submitted with
+		std::vector<VkSemaphore> SignalSemaphores;
+		std::vector<uint64_t>	 SignalValues;
+		std::vector<std::chrono::steady_clock::time_point> SubmitTimes;	//frame % Frames
+		FrameTimelineStats		 Statistics;
+	};
+}
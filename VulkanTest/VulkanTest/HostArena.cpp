@@ -0,0 +1,190 @@
+#include "HostArena.h"
+#include <algorithm>
+#include <cstdlib>
+namespace VulkanCookbook {
+	namespace {
+		uintptr_t AlignUp(uintptr_t value, size_t alignment) {
+			return (value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+		}
+		size_t ClassSize(uint32_t sizeClass) {
+			return size_t(16) << sizeClass;
+		}
+	}
+
+	const char* SystemAllocationScopeName(VkSystemAllocationScope scope) {
+		switch (scope) {
+		case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:  return "command";
+		case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:	  return "object";
+		case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:	  return "cache";
+		case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:	  return "device";
+		case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE: return "instance";
+		default:								  return "unknown";
+		}
+	}
+
+	HostArena::HostArena(const char* name) : Name(name) {
+		AllocationCallbacks = {
+			this,							//pUserData
+			AllocationFunction,				//pfnAllocation
+			ReallocationFunction,			//pfnReallocation
+			FreeFunction,					//pfnFree
+			InternalAllocationNotification,	//pfnInternalAllocation
+			InternalFreeNotification		//pfnInternalFree
+		};
+	}
+
+	HostArena::~HostArena() {
+		for (size_t scope = 0; scope < SystemAllocationScopeCount; ++scope) {
+			if (Pools[scope].Stats.AllocationCount > 0)
+				std::cout << Name << " host arena destroyed with " << Pools[scope].Stats.AllocationCount << " live "
+						  << SystemAllocationScopeName(static_cast<VkSystemAllocationScope>(scope)) << " allocation(s)." << std::endl;
+			for (void* slab : Pools[scope].Slabs)
+				std::free(slab);
+		}
+	}
+
+	HostArenaStats HostArena::Stats() const {
+		HostArenaStats stats;
+		for (size_t scope = 0; scope < SystemAllocationScopeCount; ++scope) {
+			std::lock_guard<std::mutex> lock(Pools[scope].Mutex);
+			stats.Scopes[scope] = Pools[scope].Stats;
+		}
+		std::lock_guard<std::mutex> lock(InternalMutex);
+		stats.InternalBytes = InternalBytes;
+		return stats;
+	}
+
+	void HostArena::PrintStats(std::ostream& stream) const {
+		HostArenaStats stats = Stats();
+		stream << Name << " host memory: " << stats.InternalBytes << " internal bytes" << std::endl;
+		for (size_t scope = 0; scope < SystemAllocationScopeCount; ++scope) {
+			const HostScopeStats& scopeStats = stats.Scopes[scope];
+			if (scopeStats.TotalAllocations == 0)
+				continue;
+			stream << "    " << SystemAllocationScopeName(static_cast<VkSystemAllocationScope>(scope)) << ": "
+				   << scopeStats.AllocationCount << " allocation(s), " << scopeStats.Bytes << " bytes (peak " << scopeStats.PeakBytes
+				   << "), " << scopeStats.TotalAllocations << " in total, " << scopeStats.SlabBytes << " bytes of slabs" << std::endl;
+		}
+	}
+
+	void* HostArena::AllocationFunction(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+		return static_cast<HostArena*>(userData)->Allocate(size, alignment, scope);
+	}
+
+	//The spec requires the new block to keep the original's alignment; both paths below guarantee at
+	//least the requested alignment, so a block is reused in place when it is large enough.
+	void* HostArena::ReallocationFunction(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+		HostArena& arena = *static_cast<HostArena*>(userData);
+		if (!original)
+			return arena.Allocate(size, alignment, scope);
+		if (size == 0) {
+			arena.Release(original);
+			return nullptr;
+		}
+		Header* header = static_cast<Header*>(original) - 1;
+		if (!header->Raw && size <= ClassSize(header->Class) && alignment <= MaxAlignment && header->Scope == scope) {
+			ScopePools& pools = arena.Pools[scope];
+			std::lock_guard<std::mutex> lock(pools.Mutex);
+			pools.Stats.Bytes = pools.Stats.Bytes - header->Size + size;
+			pools.Stats.PeakBytes = std::max(pools.Stats.PeakBytes, pools.Stats.Bytes);
+			++pools.Stats.TotalAllocations;
+			header->Size = static_cast<uint32_t>(size);
+			return original;
+		}
+		void* memory = arena.Allocate(size, alignment, scope);
+		if (!memory)
+			return nullptr;	//the original stays valid
+		std::memcpy(memory, original, std::min<size_t>(size, header->Size));
+		arena.Release(original);
+		return memory;
+	}
+
+	void HostArena::FreeFunction(void* userData, void* memory) {
+		static_cast<HostArena*>(userData)->Release(memory);
+	}
+
+	void HostArena::InternalAllocationNotification(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope) {
+		HostArena& arena = *static_cast<HostArena*>(userData);
+		std::lock_guard<std::mutex> lock(arena.InternalMutex);
+		arena.InternalBytes += size;
+	}
+
+	void HostArena::InternalFreeNotification(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope) {
+		HostArena& arena = *static_cast<HostArena*>(userData);
+		std::lock_guard<std::mutex> lock(arena.InternalMutex);
+		arena.InternalBytes -= size;
+	}
+
+	void* HostArena::Allocate(size_t size, size_t alignment, VkSystemAllocationScope scope) {
+		if (size == 0 || size > UINT32_MAX || static_cast<size_t>(scope) >= SystemAllocationScopeCount)
+			return nullptr;
+		ScopePools& pools = Pools[scope];
+		Header* header;
+		if (size <= ClassSize(ClassCount - 1) && alignment <= MaxAlignment) {
+			uint32_t sizeClass = 0;
+			while (ClassSize(sizeClass) < size)
+				++sizeClass;
+			std::lock_guard<std::mutex> lock(pools.Mutex);
+			if (!pools.FreeLists[sizeClass] && !GrowPool(pools, sizeClass))
+				return nullptr;
+			header = pools.FreeLists[sizeClass];
+			pools.FreeLists[sizeClass] = *reinterpret_cast<Header**>(header + 1);
+			header->Raw = nullptr;
+			header->Class = static_cast<uint16_t>(sizeClass);
+		} else {
+			alignment = std::max(alignment, MaxAlignment);
+			void* raw = std::malloc(size + alignment + sizeof(Header));
+			if (!raw)
+				return nullptr;
+			header = reinterpret_cast<Header*>(AlignUp(reinterpret_cast<uintptr_t>(raw) + sizeof(Header), alignment)) - 1;
+			header->Raw = raw;
+			header->Class = ClassCount;
+		}
+		header->Size = static_cast<uint32_t>(size);
+		header->Scope = static_cast<uint16_t>(scope);
+
+		std::lock_guard<std::mutex> lock(pools.Mutex);
+		++pools.Stats.AllocationCount;
+		++pools.Stats.TotalAllocations;
+		pools.Stats.Bytes += size;
+		pools.Stats.PeakBytes = std::max(pools.Stats.PeakBytes, pools.Stats.Bytes);
+		return header + 1;
+	}
+
+	void HostArena::Release(void* memory) {
+		if (!memory)
+			return;
+		Header* header = static_cast<Header*>(memory) - 1;
+		ScopePools& pools = Pools[header->Scope];
+		void* raw = header->Raw;
+		{
+			std::lock_guard<std::mutex> lock(pools.Mutex);
+			--pools.Stats.AllocationCount;
+			pools.Stats.Bytes -= header->Size;
+			if (!raw) {
+				*reinterpret_cast<Header**>(header + 1) = pools.FreeLists[header->Class];
+				pools.FreeLists[header->Class] = header;
+			}
+		}
+		std::free(raw);
+	}
+
+	//Slabs are never returned before the arena is destroyed; each scope's pools stay at its peak.
+	bool HostArena::GrowPool(ScopePools& pools, uint32_t sizeClass) {
+		size_t stride = sizeof(Header) + ClassSize(sizeClass);
+		size_t slotCount = std::max<size_t>(SlabSize / stride, 1);
+		void* slab = std::malloc(slotCount * stride + MaxAlignment);
+		if (!slab)
+			return false;
+		pools.Slabs.push_back(slab);
+		pools.Stats.SlabBytes += slotCount * stride + MaxAlignment;
+
+		char* slot = reinterpret_cast<char*>(AlignUp(reinterpret_cast<uintptr_t>(slab), MaxAlignment));
+		for (size_t index = 0; index < slotCount; ++index, slot += stride) {
+			Header* header = reinterpret_cast<Header*>(slot);
+			*reinterpret_cast<Header**>(header + 1) = pools.FreeLists[sizeClass];
+			pools.FreeLists[sizeClass] = header;
+		}
+		return true;
+	}
+}
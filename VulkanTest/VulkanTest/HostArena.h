@@ -0,0 +1,76 @@
+#pragma once
+#include "Common.h"
+#include <mutex>
+namespace VulkanCookbook {
+	constexpr size_t SystemAllocationScopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+	const char* SystemAllocationScopeName(VkSystemAllocationScope scope);
+
+	struct HostScopeStats {
+		uint64_t AllocationCount  = 0;	//live
+		uint64_t Bytes			  = 0;	//live, as requested by the driver
+		uint64_t PeakBytes		  = 0;
+		uint64_t TotalAllocations = 0;	//every allocation and reallocation since creation
+		uint64_t SlabBytes		  = 0;	//held by the scope's size-class pools
+	};
+
+	struct HostArenaStats {
+		std::array<HostScopeStats, SystemAllocationScopeCount> Scopes;
+		uint64_t											   InternalBytes = 0;	//reported through pfnInternalAllocation
+	};
+
+	//VkAllocationCallbacks that serve the driver's host allocations from size-class pools and count them
+	//per VkSystemAllocationScope. Every scope has its own pools and lock, so short-lived COMMAND scope
+	//allocations keep reusing the same few slots each frame without fragmenting the long-lived OBJECT and
+	//DEVICE ones, and threads creating different kinds of objects do not contend on one malloc lock.
+	//Allocations over 4 KiB or with an alignment over 16 go to malloc directly but are still counted.
+	//Create one arena per owner (the instance, each device) and pass Callbacks() to every create and the
+	//matching destroy of that owner's objects; the arena must outlive all of them.
+	class HostArena {
+	 public:
+		explicit HostArena(const char* name);
+		~HostArena();
+		HostArena(const HostArena&) = delete;
+		HostArena& operator=(const HostArena&) = delete;
+
+		const VkAllocationCallbacks* Callbacks() const { return &AllocationCallbacks; }
+		HostArenaStats Stats() const;
+		void PrintStats(std::ostream& stream = std::cout) const;
+	 private:
+		static constexpr uint32_t ClassCount   = 9;		//16, 32, ... 4096 bytes
+		static constexpr size_t	  SlabSize	   = 16 * 1024;
+		static constexpr size_t	  MaxAlignment = 16;
+
+		struct alignas(16) Header {
+			void*	 Raw;	//what malloc returned for a large allocation, null for a pooled one
+			uint32_t Size;
+			uint16_t Class;
+			uint16_t Scope;
+		};
+		struct ScopePools {
+			mutable std::mutex				Mutex;
+			std::array<Header*, ClassCount> FreeLists = {};
+			std::vector<void*>				Slabs;
+			HostScopeStats					Stats;
+		};
+
+		static VKAPI_ATTR void* VKAPI_CALL AllocationFunction(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+		static VKAPI_ATTR void* VKAPI_CALL ReallocationFunction(void* userData, void* original, size_t size, size_t alignment,
+																VkSystemAllocationScope scope);
+		static VKAPI_ATTR void VKAPI_CALL FreeFunction(void* userData, void* memory);
+		static VKAPI_ATTR void VKAPI_CALL InternalAllocationNotification(void* userData, size_t size, VkInternalAllocationType type,
+																		 VkSystemAllocationScope scope);
+		static VKAPI_ATTR void VKAPI_CALL InternalFreeNotification(void* userData, size_t size, VkInternalAllocationType type,
+																   VkSystemAllocationScope scope);
+
+		void* Allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+		void Release(void* memory);
+		bool GrowPool(ScopePools& pools, uint32_t sizeClass);
+
+		std::string										   Name;
+		VkAllocationCallbacks							   AllocationCallbacks;
+		std::array<ScopePools, SystemAllocationScopeCount> Pools;
+		mutable std::mutex								   InternalMutex;
+		uint64_t										   InternalBytes = 0;
+	};
+}
@@ -0,0 +1,144 @@
+#include "JobSystem.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	namespace {
+		thread_local uint32_t CurrentThread = 0;
+	}
+
+	bool JobSystem::Create(uint32_t threadCount) {
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		Queues.clear();
+		for (uint32_t thread = 0; thread < threadCount; ++thread)
+			Queues.push_back(std::make_unique<WorkQueue>());
+		Stopping = false;
+		try {
+			for (uint32_t thread = 1; thread < threadCount; ++thread)
+				Workers.emplace_back(&JobSystem::WorkerLoop, this, thread);
+		} catch (const std::system_error&) {
+			std::cout << "Could not start a job thread." << std::endl;
+			Destroy();
+			return false;
+		}
+		return true;
+	}
+
+	void JobSystem::Destroy() {
+		if (Queues.empty())
+			return;
+		{
+			std::lock_guard<std::mutex> lock(SleepMutex);
+			Stopping = true;
+		}
+		WakeCondition.notify_all();
+		for (auto& worker : Workers)
+			worker.join();
+		Workers.clear();
+		//with no workers, whatever thread 0 queued last is still there
+		while (!Queues.empty() && TryRunOne(0))
+			;
+		Queues.clear();
+	}
+
+	void JobSystem::Run(Job job, JobCounter* counter, JobCounter* dependency) {
+		if (counter) {
+			std::lock_guard<std::mutex> lock(counter->Mutex);
+			++counter->Value;
+		}
+		QueuedJob queued = { std::move(job), counter };
+		if (dependency) {
+			std::lock_guard<std::mutex> lock(dependency->Mutex);
+			if (dependency->Value > 0) {
+				dependency->Waiting.push_back(std::move(queued));
+				return;
+			}
+		}
+		Push(ThreadIndex(), std::move(queued));
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t grain, std::function<void(uint32_t first, uint32_t count)> function, JobCounter& counter) {
+		grain = std::max(grain, 1u);
+		//queued back to front, so the calling thread takes the first range next
+		for (uint32_t range = (count + grain - 1) / grain; range-- > 0;) {
+			uint32_t first = range * grain;
+			uint32_t rangeCount = std::min(grain, count - first);
+			Run([function, first, rangeCount] { function(first, rangeCount); }, &counter);
+		}
+	}
+
+	void JobSystem::Wait(JobCounter& counter) {
+		uint32_t thread = ThreadIndex();
+		while (!counter.IsDone())
+			if (!TryRunOne(thread))
+				std::this_thread::yield();
+	}
+
+	uint32_t JobSystem::ThreadIndex() {
+		return CurrentThread;
+	}
+
+	void JobSystem::Push(uint32_t thread, QueuedJob job) {
+		{
+			std::lock_guard<std::mutex> lock(Queues[thread]->Mutex);
+			Queues[thread]->Jobs.push_back(std::move(job));
+		}
+		Queued.fetch_add(1, std::memory_order_release);
+		//a worker that has just found nothing either sees the count or is already waiting for the notify
+		{ std::lock_guard<std::mutex> lock(SleepMutex); }
+		WakeCondition.notify_one();
+	}
+
+	bool JobSystem::TryRunOne(uint32_t thread) {
+		QueuedJob job;
+		bool found = false;
+		{
+			WorkQueue& own = *Queues[thread];
+			std::lock_guard<std::mutex> lock(own.Mutex);
+			if (!own.Jobs.empty()) {
+				job = std::move(own.Jobs.back());
+				own.Jobs.pop_back();
+				found = true;
+			}
+		}
+		for (uint32_t offset = 1; !found && offset < Queues.size(); ++offset) {
+			WorkQueue& victim = *Queues[(thread + offset) % Queues.size()];
+			std::lock_guard<std::mutex> lock(victim.Mutex);
+			if (!victim.Jobs.empty()) {
+				job = std::move(victim.Jobs.front());
+				victim.Jobs.pop_front();
+				found = true;
+				Steals.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		if (!found)
+			return false;
+		Queued.fetch_sub(1, std::memory_order_relaxed);
+
+		job.Function();
+		JobsRun.fetch_add(1, std::memory_order_relaxed);
+		//the counter is only touched under its lock, so whoever sees it done may destroy it right away
+		if (JobCounter* counter = job.Counter) {
+			std::vector<QueuedJob> released;
+			{
+				std::lock_guard<std::mutex> lock(counter->Mutex);
+				if (--counter->Value == 0)
+					released.swap(counter->Waiting);
+			}
+			for (auto& waiting : released)
+				Push(thread, std::move(waiting));
+		}
+		return true;
+	}
+
+	void JobSystem::WorkerLoop(uint32_t thread) {
+		CurrentThread = thread;
+		for (;;) {
+			if (TryRunOne(thread))
+				continue;
+			std::unique_lock<std::mutex> lock(SleepMutex);
+			WakeCondition.wait(lock, [this] { return Stopping || Queued.load(std::memory_order_acquire) > 0; });
+			if (Stopping && Queued.load(std::memory_order_acquire) == 0)
+				return;
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "Common.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+namespace VulkanCookbook {
+	using Job = std::function<void()>;
+
+	class JobCounter;
+	struct QueuedJob {
+		Job			Function;
+		JobCounter* Counter = nullptr;	//taken one off when Function returns
+	};
+
+	//The number of unfinished jobs started with it. Jobs started after a counter are held back until it
+	//reaches zero; they are counted by their own counter meanwhile. Must outlive the jobs that use it;
+	//once IsDone, the last job has let go of it and it may be destroyed.
+	class JobCounter {
+	 public:
+		bool IsDone() {
+			std::lock_guard<std::mutex> lock(Mutex);
+			return Value == 0;
+		}
+	 private:
+		friend class JobSystem;
+		std::mutex			   Mutex;
+		uint32_t			   Value = 0;
+		std::vector<QueuedJob> Waiting;
+	};
+
+	struct JobSystemStats {
+		uint64_t Jobs	= 0;
+		uint64_t Steals = 0;	//jobs run by a thread other than the one that queued them
+	};
+
+	//One worker thread per hardware thread beyond the caller's, each with its own deque. A thread queues
+	//the jobs it starts at the back of its own deque and also takes its next job from the back, so it
+	//keeps working on what it touched last; an idle thread steals from the front of another deque, where
+	//the oldest and usually largest pieces of work are. Wait runs jobs until the counter is zero instead
+	//of blocking, so a job may wait for the jobs it started without fibers and without starving the pool.
+	//Thread 0 is every thread that is not a worker, normally the one that created the system, and only
+	//one of those may run jobs at a time; workers are 1 to ThreadCount() - 1. Per-thread resources, such
+	//as command pools, are indexed by ThreadIndex(). One system per process. Jobs must not throw.
+	class JobSystem {
+	 public:
+		~JobSystem() { Destroy(); }
+
+		//threadCount 0 means one thread per hardware thread.
+		bool Create(uint32_t threadCount = 0);
+		//Runs the queued jobs and joins the workers. Jobs still held back by a counter are dropped. Does
+		//nothing if the system was not created or is already destroyed.
+		void Destroy();
+
+		//counter, if given, counts the job until it returns; the job starts once dependency, if given, is zero.
+		void Run(Job job, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+		//Calls function(first, count) for ranges of at most grain covering [0, count), as one job each.
+		void ParallelFor(uint32_t count, uint32_t grain, std::function<void(uint32_t first, uint32_t count)> function, JobCounter& counter);
+		//Runs jobs, the calling thread's own first, until counter is zero.
+		void Wait(JobCounter& counter);
+
+		uint32_t ThreadCount() const { return static_cast<uint32_t>(Queues.size()); }
+		static uint32_t ThreadIndex();
+		JobSystemStats Stats() const { return { JobsRun.load(), Steals.load() }; }
+	 private:
+		struct WorkQueue {
+			std::mutex			  Mutex;
+			std::deque<QueuedJob> Jobs;
+		};
+
+		void Push(uint32_t thread, QueuedJob job);
+		bool TryRunOne(uint32_t thread);
+		void WorkerLoop(uint32_t thread);
+
+		std::vector<std::unique_ptr<WorkQueue>> Queues;	//one per thread
+		std::vector<std::thread>				Workers;
+		std::mutex								SleepMutex;
+		std::condition_variable					WakeCondition;
+		std::atomic<uint32_t>					Queued{ 0 };	//jobs in all deques
+		bool									Stopping = false;	//guarded by SleepMutex
+		std::atomic<uint64_t>					JobsRun{ 0 };
+		std::atomic<uint64_t>					Steals{ 0 };
+	};
+}
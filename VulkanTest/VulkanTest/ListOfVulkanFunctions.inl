@@ -49,6 +49,7 @@ INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkGetPhysicalDeviceSurfaceCapabili
 INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkGetPhysicalDeviceSurfaceFormatsKHR, VK_KHR_SURFACE_EXTENSION_NAME)
 INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkGetPhysicalDeviceSurfacePresentModesKHR, VK_KHR_SURFACE_EXTENSION_NAME)
 INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkDestroySurfaceKHR, VK_KHR_SURFACE_EXTENSION_NAME)
+INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkGetPhysicalDeviceMemoryProperties2KHR, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)
 
 #ifdef VK_USE_PLATFORM_WIN32_KHR
 INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCreateWin32SurfaceKHR, VK_KHR_WIN32_SURFACE_EXTENSION_NAME)
@@ -84,6 +85,7 @@ DEVICE_LEVEL_VULKAN_FUNCTION(vkUnmapMemory)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdCopyBuffer)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdCopyBufferToImage)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdCopyImageToBuffer)
+DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdBlitImage)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkBeginCommandBuffer)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkEndCommandBuffer)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkQueueSubmit)
@@ -97,6 +99,7 @@ DEVICE_LEVEL_VULKAN_FUNCTION(vkCreateSemaphore)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkCreateFence)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkWaitForFences)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkResetFences)
+DEVICE_LEVEL_VULKAN_FUNCTION(vkGetFenceStatus)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkDestroyFence)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkDestroySemaphore)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkResetCommandBuffer)
@@ -169,4 +172,9 @@ DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkAcquireNextImageKHR, VK_KHR_SWAPCH
 DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkQueuePresentKHR, VK_KHR_SWAPCHAIN_EXTENSION_NAME)
 DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkDestroySwapchainKHR, VK_KHR_SWAPCHAIN_EXTENSION_NAME)
 
+#ifdef VK_KHR_timeline_semaphore
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkGetSemaphoreCounterValueKHR, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkWaitSemaphoresKHR, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)
+#endif
+
 #undef DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION
\ No newline at end of file
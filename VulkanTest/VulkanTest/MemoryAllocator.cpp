@@ -0,0 +1,582 @@
+#include "MemoryBlock.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	class MemoryPool {
+	 public:
+		explicit MemoryPool(const PoolCreateInfo& createInfo) : Info(createInfo) {}
+
+		PoolCreateInfo								   Info;
+		std::vector<std::unique_ptr<MemoryBlock>>	   Blocks;
+		std::array<CategoryStats, MemoryCategoryCount> Categories = {};	//what ResetPool takes out of the totals
+	};
+
+	const char* MemoryCategoryName(MemoryCategory category) {
+		switch (category) {
+		case MemoryCategory::Attachment: return "attachments";
+		case MemoryCategory::Texture:	 return "textures";
+		case MemoryCategory::Geometry:	 return "geometry";
+		case MemoryCategory::Staging:	 return "staging";
+		case MemoryCategory::Uniform:	 return "uniforms";
+		default:						 return "other";
+		}
+	}
+
+	double MemoryTypeStats::Fragmentation() const {
+		VkDeviceSize freeBytes = BlockBytes - UsedBytes;
+		return freeBytes == 0 ? 0.0 : 1.0 - static_cast<double>(LargestFreeRange) / static_cast<double>(freeBytes);
+	}
+
+	void MemoryTypeStats::Add(const MemoryTypeStats& other) {
+		BlockCount += other.BlockCount;
+		AllocationCount += other.AllocationCount;
+		BlockBytes += other.BlockBytes;
+		UsedBytes += other.UsedBytes;
+		FreeRangeCount += other.FreeRangeCount;
+		LargestFreeRange = std::max(LargestFreeRange, other.LargestFreeRange);
+	}
+
+	DeviceMemoryAllocator::DeviceMemoryAllocator(const LogicalDevice& logicalDevice, const PhysicalDeviceInfo& deviceInfo,
+												 VkDeviceSize preferredBlockSize)
+		: LogicalDeviceRef(logicalDevice),
+		  PhysicalDeviceRef(deviceInfo),
+		  PreferredBlockSize(preferredBlockSize),
+		  SeparateResourceKinds(deviceInfo.Limits().bufferImageGranularity > 1),
+		  DefaultPools(deviceInfo.MemoryProperties().memoryTypeCount * 2),
+		  DedicatedStats(deviceInfo.MemoryProperties().memoryTypeCount),
+		  HeapBlockBytes(deviceInfo.MemoryProperties().memoryHeapCount),
+		  HeapBlockBytesAtUpdate(deviceInfo.MemoryProperties().memoryHeapCount),
+		  DriverHeapUsage(deviceInfo.MemoryProperties().memoryHeapCount),
+		  DriverHeapBudget(deviceInfo.MemoryProperties().memoryHeapCount) {
+		UpdateBudget();
+	}
+
+	DeviceMemoryAllocator::~DeviceMemoryAllocator() {
+		AllocatorStats stats = Stats();
+		if (stats.Total.AllocationCount > 0)
+			std::cout << "Destroying the memory allocator with " << stats.Total.AllocationCount << " live allocation(s)." << std::endl;
+		for (auto* pools : { &DefaultPools, &CustomPools })
+			for (auto& pool : *pools)
+				if (pool)
+					for (auto& block : pool->Blocks)
+						FreeDeviceMemory(block->Memory, pool->Info.MemoryTypeIndex, block->Size);
+	}
+
+	VkDeviceSize DeviceMemoryAllocator::DefaultBlockSize(uint32_t memoryTypeIndex) const {
+		if (PreferredBlockSize > 0)
+			return PreferredBlockSize;
+		auto& memoryProperties = PhysicalDeviceRef.MemoryProperties();
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+		const VkDeviceSize largeHeapBlockSize = 256ull * 1024 * 1024;
+		return heapSize <= 1024ull * 1024 * 1024 ? heapSize / 8 : largeHeapBlockSize;
+	}
+
+	MemoryPool& DeviceMemoryAllocator::DefaultPool(uint32_t memoryTypeIndex, ResourceKind kind) {
+		ResourceKind poolKind = SeparateResourceKinds ? kind : ResourceKind::Linear;
+		auto& pool = DefaultPools[memoryTypeIndex * 2 + static_cast<uint32_t>(poolKind)];
+		if (!pool) {
+			PoolCreateInfo createInfo;
+			createInfo.MemoryTypeIndex = memoryTypeIndex;
+			createInfo.Kind = poolKind;
+			createInfo.BlockSize = DefaultBlockSize(memoryTypeIndex);
+			pool = std::make_unique<MemoryPool>(createInfo);
+		}
+		return *pool;
+	}
+
+	bool DeviceMemoryAllocator::AllocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& memory, void*& mapped) {
+		if (DeviceMemoryAllocations >= PhysicalDeviceRef.Limits().maxMemoryAllocationCount) {
+			std::cout << "Reached maxMemoryAllocationCount (" << DeviceMemoryAllocations << ")." << std::endl;
+			return false;
+		}
+		uint32_t heapIndex = PhysicalDeviceRef.MemoryProperties().memoryTypes[memoryTypeIndex].heapIndex;
+		VkDeviceSize usage, budget;
+		HeapBudget(heapIndex, usage, budget);
+		if (usage + size > budget) {
+			std::cout << "Allocating " << size << " bytes of memory type " << memoryTypeIndex << " would exceed the budget of heap "
+					  << heapIndex << " (" << usage << "/" << budget << " bytes in use)." << std::endl;
+			return false;
+		}
+		VkMemoryAllocateInfo allocateInfo = {
+			VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,	//sType
+			nullptr,								//pNext
+			size,									//allocationSize
+			memoryTypeIndex							//memoryTypeIndex
+		};
+		if (LogicalDeviceRef.Dispatch.vkAllocateMemory(LogicalDeviceRef.Handle, &allocateInfo, LogicalDeviceRef.HostCallbacks, &memory) != VK_SUCCESS) {
+			std::cout << "Could not allocate " << size << " bytes of memory type " << memoryTypeIndex << "." << std::endl;
+			return false;
+		}
+		++DeviceMemoryAllocations;
+		HeapBlockBytes[heapIndex] += size;
+
+		mapped = nullptr;
+		if (PhysicalDeviceRef.MemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			if (LogicalDeviceRef.Dispatch.vkMapMemory(LogicalDeviceRef.Handle, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+				std::cout << "Could not map memory of type " << memoryTypeIndex << "." << std::endl;
+				FreeDeviceMemory(memory, memoryTypeIndex, size);
+				return false;
+			}
+		return true;
+	}
+
+	//vkFreeMemory unmaps implicitly.
+	void DeviceMemoryAllocator::FreeDeviceMemory(VkDeviceMemory& memory, uint32_t memoryTypeIndex, VkDeviceSize size) {
+		if (memory) {
+			LogicalDeviceRef.Dispatch.vkFreeMemory(LogicalDeviceRef.Handle, memory, LogicalDeviceRef.HostCallbacks);
+			memory = VK_NULL_HANDLE;
+			--DeviceMemoryAllocations;
+			HeapBlockBytes[PhysicalDeviceRef.MemoryProperties().memoryTypes[memoryTypeIndex].heapIndex] -= size;
+		}
+	}
+
+	void DeviceMemoryAllocator::HeapBudget(uint32_t heapIndex, VkDeviceSize& usage, VkDeviceSize& budget) const {
+		if (BudgetFromDriver) {
+			//the driver's usage already counts the blocks that existed when it was read
+			VkDeviceSize driverUsage = DriverHeapUsage[heapIndex] + HeapBlockBytes[heapIndex];
+			usage = driverUsage > HeapBlockBytesAtUpdate[heapIndex] ? driverUsage - HeapBlockBytesAtUpdate[heapIndex] : 0;
+			budget = DriverHeapBudget[heapIndex];
+		}
+		else {
+			usage = HeapBlockBytes[heapIndex];
+			budget = PhysicalDeviceRef.MemoryProperties().memoryHeaps[heapIndex].size / 10 * 8;
+		}
+	}
+
+	void DeviceMemoryAllocator::UpdateBudget() {
+	#ifdef VK_EXT_memory_budget
+		if (!vkGetPhysicalDeviceMemoryProperties2KHR || !PhysicalDeviceRef.Extensions().Contains(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+			return;
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {
+			VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,	//sType
+			nullptr,														//pNext
+			{},																//heapBudget
+			{}																//heapUsage
+		};
+		VkPhysicalDeviceMemoryProperties2KHR memoryProperties = {
+			VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR,		//sType
+			&budgetProperties,												//pNext
+			{}																//memoryProperties
+		};
+		vkGetPhysicalDeviceMemoryProperties2KHR(PhysicalDeviceRef.Handle(), &memoryProperties);
+
+		std::lock_guard<std::mutex> lock(Mutex);
+		for (uint32_t heapIndex = 0; heapIndex < static_cast<uint32_t>(HeapBlockBytes.size()); ++heapIndex) {
+			DriverHeapUsage[heapIndex] = budgetProperties.heapUsage[heapIndex];
+			DriverHeapBudget[heapIndex] = budgetProperties.heapBudget[heapIndex];
+			HeapBlockBytesAtUpdate[heapIndex] = HeapBlockBytes[heapIndex];
+		}
+		BudgetFromDriver = true;
+	#endif
+	}
+
+	bool DeviceMemoryAllocator::AllocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, Allocation& allocation) {
+		VkDeviceMemory memory;
+		void* mapped;
+		if (!AllocateDeviceMemory(memoryTypeIndex, size, memory, mapped))
+			return false;
+		allocation = {};
+		allocation.Memory = memory;
+		allocation.Size = size;
+		allocation.Mapped = mapped;
+		allocation.MemoryTypeIndex = memoryTypeIndex;
+
+		MemoryTypeStats& stats = DedicatedStats[memoryTypeIndex];
+		++stats.BlockCount;
+		++stats.AllocationCount;
+		stats.BlockBytes += size;
+		stats.UsedBytes += size;
+		return true;
+	}
+
+	bool DeviceMemoryAllocator::AllocateFromPool(MemoryPool& pool, const VkMemoryRequirements& requirements, Allocation& allocation) {
+		VkDeviceSize offset;
+		uint32_t segment;
+		auto fill = [&](MemoryBlock& block) {
+			allocation = {};
+			allocation.Memory = block.Memory;
+			allocation.Offset = offset;
+			allocation.Size = requirements.size;
+			allocation.Mapped = block.Mapped ? static_cast<char*>(block.Mapped) + offset : nullptr;
+			allocation.MemoryTypeIndex = pool.Info.MemoryTypeIndex;
+			allocation.Pool = &pool;
+			allocation.Block = &block;
+			allocation.Segment = segment;
+			return true;
+		};
+		for (auto& block : pool.Blocks)
+			if (block->Allocate(requirements.size, requirements.alignment, offset, segment))
+				return fill(*block);
+
+		if (pool.Info.MaxBlocks > 0 && pool.Blocks.size() >= pool.Info.MaxBlocks) {
+			std::cout << "Memory pool is full." << std::endl;
+			return false;
+		}
+		//the first blocks of a pool start at 1/8, 1/4 and 1/2 of the full size so small scenes stay small
+		VkDeviceSize blockSize = std::max(pool.Info.BlockSize, requirements.size);
+		for (size_t shift = pool.Blocks.size(); shift < 3 && blockSize / 2 >= requirements.size * 2; ++shift)
+			blockSize /= 2;
+		VkDeviceMemory memory;
+		void* mapped;
+		if (!AllocateDeviceMemory(pool.Info.MemoryTypeIndex, blockSize, memory, mapped))
+			return false;
+		pool.Blocks.push_back(std::make_unique<MemoryBlock>(memory, blockSize, mapped, pool.Info.Strategy));
+		if (!pool.Blocks.back()->Allocate(requirements.size, requirements.alignment, offset, segment))
+			return false;
+		return fill(*pool.Blocks.back());
+	}
+
+	bool DeviceMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, const AllocationCreateInfo& createInfo,
+										 Allocation& allocation) {
+		std::lock_guard<std::mutex> lock(Mutex);
+		auto track = [&]() {
+			allocation.Category = createInfo.Category;
+			CountCategory(allocation, true);
+			return true;
+		};
+		if (createInfo.Pool) {
+			if (!(requirements.memoryTypeBits & (1u << createInfo.Pool->Info.MemoryTypeIndex))) {
+				std::cout << "Memory pool's memory type is not allowed for this resource." << std::endl;
+				return false;
+			}
+			return AllocateFromPool(*createInfo.Pool, requirements, allocation) && track();
+		}
+
+		MemoryTypePreference preference;
+		preference.Required = createInfo.RequiredFlags;
+		preference.Preferred = createInfo.PreferredFlags;
+		preference.Avoided = createInfo.AvoidedFlags;
+		uint32_t candidates = requirements.memoryTypeBits;
+		uint32_t memoryTypeIndex;
+		if (!PhysicalDeviceRef.FindMemoryType(candidates, preference, memoryTypeIndex)) {
+			std::cout << "Could not find a suitable memory type." << std::endl;
+			return false;
+		}
+		do {
+			bool allocated = createInfo.Dedicated || requirements.size > DefaultBlockSize(memoryTypeIndex) / 2 ?
+				AllocateDedicated(memoryTypeIndex, requirements.size, allocation) :
+				AllocateFromPool(DefaultPool(memoryTypeIndex, createInfo.Kind), requirements, allocation);
+			if (allocated)
+				return track();
+			candidates &= ~(1u << memoryTypeIndex);
+		} while (PhysicalDeviceRef.FindMemoryType(candidates, preference, memoryTypeIndex));
+		return false;
+	}
+
+	//Normally keeps one empty block per pool around so that a free/allocate pair does not hit the driver.
+	void DeviceMemoryAllocator::ReleaseEmptyBlocks(MemoryPool& pool, bool keepOne) {
+		bool keptOne = !keepOne;
+		for (auto block = pool.Blocks.begin(); block != pool.Blocks.end();) {
+			if ((*block)->Empty() && keptOne) {
+				FreeDeviceMemory((*block)->Memory, pool.Info.MemoryTypeIndex, (*block)->Size);
+				block = pool.Blocks.erase(block);
+				continue;
+			}
+			keptOne = keptOne || (*block)->Empty();
+			++block;
+		}
+	}
+
+	void DeviceMemoryAllocator::Free(Allocation& allocation) {
+		if (!allocation.Memory)
+			return;
+		std::lock_guard<std::mutex> lock(Mutex);
+		CountCategory(allocation, false);
+		if (!allocation.Block) {
+			MemoryTypeStats& stats = DedicatedStats[allocation.MemoryTypeIndex];
+			--stats.BlockCount;
+			--stats.AllocationCount;
+			stats.BlockBytes -= allocation.Size;
+			stats.UsedBytes -= allocation.Size;
+			FreeDeviceMemory(allocation.Memory, allocation.MemoryTypeIndex, allocation.Size);
+		}
+		else {
+			allocation.Block->Free(allocation.Segment, allocation.Size);
+			if (allocation.Block->Empty())
+				ReleaseEmptyBlocks(*allocation.Pool);
+		}
+		allocation = {};
+	}
+
+	bool DeviceMemoryAllocator::CreateBuffer(const VkBufferCreateInfo& bufferInfo, const AllocationCreateInfo& createInfo,
+											 VkBuffer& buffer, Allocation& allocation) {
+		auto& dispatch = LogicalDeviceRef.Dispatch;
+		if (dispatch.vkCreateBuffer(LogicalDeviceRef.Handle, &bufferInfo, LogicalDeviceRef.HostCallbacks, &buffer) != VK_SUCCESS) {
+			std::cout << "Could not create a buffer." << std::endl;
+			return false;
+		}
+		VkMemoryRequirements requirements;
+		dispatch.vkGetBufferMemoryRequirements(LogicalDeviceRef.Handle, buffer, &requirements);
+
+		AllocationCreateInfo bufferCreateInfo = createInfo;
+		bufferCreateInfo.Kind = ResourceKind::Linear;
+		if (!Allocate(requirements, bufferCreateInfo, allocation)) {
+			dispatch.vkDestroyBuffer(LogicalDeviceRef.Handle, buffer, LogicalDeviceRef.HostCallbacks);
+			buffer = VK_NULL_HANDLE;
+			return false;
+		}
+		if (dispatch.vkBindBufferMemory(LogicalDeviceRef.Handle, buffer, allocation.Memory, allocation.Offset) != VK_SUCCESS) {
+			std::cout << "Could not bind memory to a buffer." << std::endl;
+			DestroyBuffer(buffer, allocation);
+			return false;
+		}
+		return true;
+	}
+
+	bool DeviceMemoryAllocator::CreateImage(const VkImageCreateInfo& imageInfo, const AllocationCreateInfo& createInfo,
+											VkImage& image, Allocation& allocation) {
+		auto& dispatch = LogicalDeviceRef.Dispatch;
+		if (dispatch.vkCreateImage(LogicalDeviceRef.Handle, &imageInfo, LogicalDeviceRef.HostCallbacks, &image) != VK_SUCCESS) {
+			std::cout << "Could not create an image." << std::endl;
+			return false;
+		}
+		VkMemoryRequirements requirements;
+		dispatch.vkGetImageMemoryRequirements(LogicalDeviceRef.Handle, image, &requirements);
+
+		AllocationCreateInfo imageCreateInfo = createInfo;
+		imageCreateInfo.Kind = imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? ResourceKind::Optimal : ResourceKind::Linear;
+		if (!Allocate(requirements, imageCreateInfo, allocation)) {
+			dispatch.vkDestroyImage(LogicalDeviceRef.Handle, image, LogicalDeviceRef.HostCallbacks);
+			image = VK_NULL_HANDLE;
+			return false;
+		}
+		if (dispatch.vkBindImageMemory(LogicalDeviceRef.Handle, image, allocation.Memory, allocation.Offset) != VK_SUCCESS) {
+			std::cout << "Could not bind memory to an image." << std::endl;
+			DestroyImage(image, allocation);
+			return false;
+		}
+		return true;
+	}
+
+	void DeviceMemoryAllocator::DestroyBuffer(VkBuffer& buffer, Allocation& allocation) {
+		if (buffer) {
+			LogicalDeviceRef.Dispatch.vkDestroyBuffer(LogicalDeviceRef.Handle, buffer, LogicalDeviceRef.HostCallbacks);
+			buffer = VK_NULL_HANDLE;
+		}
+		Free(allocation);
+	}
+
+	void DeviceMemoryAllocator::DestroyImage(VkImage& image, Allocation& allocation) {
+		if (image) {
+			LogicalDeviceRef.Dispatch.vkDestroyImage(LogicalDeviceRef.Handle, image, LogicalDeviceRef.HostCallbacks);
+			image = VK_NULL_HANDLE;
+		}
+		Free(allocation);
+	}
+
+	bool DeviceMemoryAllocator::AllocateForMove(const Allocation& source, const VkMemoryRequirements& requirements,
+												Allocation& destination) {
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (!source.Block || source.Pool->Info.Strategy != PoolStrategy::Tlsf ||
+			!(requirements.memoryTypeBits & (1u << source.MemoryTypeIndex)))
+			return false;
+		//fullest blocks first, and only blocks fuller than the source, so moves never bounce back
+		std::vector<MemoryBlock*> targets;
+		for (auto& block : source.Pool->Blocks)
+			if (block.get() != source.Block && block->UsedBytes() > source.Block->UsedBytes())
+				targets.push_back(block.get());
+		std::sort(targets.begin(), targets.end(), [](const MemoryBlock* a, const MemoryBlock* b) {
+			return a->UsedBytes() > b->UsedBytes();
+		});
+		for (MemoryBlock* block : targets) {
+			VkDeviceSize offset;
+			uint32_t segment;
+			if (!block->Allocate(requirements.size, requirements.alignment, offset, segment))
+				continue;
+			destination = {};
+			destination.Memory = block->Memory;
+			destination.Offset = offset;
+			destination.Size = requirements.size;
+			destination.Mapped = block->Mapped ? static_cast<char*>(block->Mapped) + offset : nullptr;
+			destination.MemoryTypeIndex = source.MemoryTypeIndex;
+			destination.Pool = source.Pool;
+			destination.Block = block;
+			destination.Segment = segment;
+			destination.Category = source.Category;
+			CountCategory(destination, true);
+			return true;
+		}
+		return false;
+	}
+
+	double DeviceMemoryAllocator::Occupancy(const Allocation& allocation) const {
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (!allocation.Block)
+			return 1.0;
+		return static_cast<double>(allocation.Block->UsedBytes()) / static_cast<double>(allocation.Block->Size);
+	}
+
+	void DeviceMemoryAllocator::TrimEmptyBlocks() {
+		std::lock_guard<std::mutex> lock(Mutex);
+		for (auto* pools : { &DefaultPools, &CustomPools })
+			for (auto& pool : *pools)
+				if (pool)
+					ReleaseEmptyBlocks(*pool, false);
+	}
+
+	bool DeviceMemoryAllocator::Write(const Allocation& allocation, const void* data, VkDeviceSize size, VkDeviceSize offset) {
+		if (!allocation.Mapped) {
+			std::cout << "Cannot write to memory that is not host-visible." << std::endl;
+			return false;
+		}
+		memcpy(static_cast<char*>(allocation.Mapped) + offset, data, static_cast<size_t>(size));
+		if (PhysicalDeviceRef.MemoryProperties().memoryTypes[allocation.MemoryTypeIndex].propertyFlags &
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+			return true;
+		//flushed ranges must be multiples of nonCoherentAtomSize or reach the end of the memory object
+		VkDeviceSize atom = std::max<VkDeviceSize>(PhysicalDeviceRef.Limits().nonCoherentAtomSize, 1);
+		VkDeviceSize begin = (allocation.Offset + offset) / atom * atom;
+		VkDeviceSize end = (allocation.Offset + offset + size + atom - 1) / atom * atom;
+		VkDeviceSize memorySize = allocation.Block ? allocation.Block->Size : allocation.Size;
+		VkMappedMemoryRange range = {
+			VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,			//sType
+			nullptr,										//pNext
+			allocation.Memory,								//memory
+			begin,											//offset
+			end < memorySize ? end - begin : VK_WHOLE_SIZE	//size
+		};
+		return LogicalDeviceRef.Dispatch.vkFlushMappedMemoryRanges(LogicalDeviceRef.Handle, 1, &range) == VK_SUCCESS;
+	}
+
+	MemoryPool* DeviceMemoryAllocator::CreatePool(const PoolCreateInfo& createInfo) {
+		if (createInfo.MemoryTypeIndex >= PhysicalDeviceRef.MemoryProperties().memoryTypeCount) {
+			std::cout << "Invalid memory type for a memory pool." << std::endl;
+			return nullptr;
+		}
+		std::lock_guard<std::mutex> lock(Mutex);
+		PoolCreateInfo poolInfo = createInfo;
+		if (poolInfo.BlockSize == 0)
+			poolInfo.BlockSize = DefaultBlockSize(poolInfo.MemoryTypeIndex);
+		CustomPools.push_back(std::make_unique<MemoryPool>(poolInfo));
+		return CustomPools.back().get();
+	}
+
+	void DeviceMemoryAllocator::DestroyPool(MemoryPool*& pool) {
+		if (!pool)
+			return;
+		std::lock_guard<std::mutex> lock(Mutex);
+		auto found = std::find_if(CustomPools.begin(), CustomPools.end(), [pool](const std::unique_ptr<MemoryPool>& custom) {
+			return custom.get() == pool;
+		});
+		if (found != CustomPools.end()) {
+			for (auto& block : pool->Blocks)
+				FreeDeviceMemory(block->Memory, pool->Info.MemoryTypeIndex, block->Size);
+			CustomPools.erase(found);
+		}
+		pool = nullptr;
+	}
+
+	void DeviceMemoryAllocator::ResetPool(MemoryPool* pool) {
+		if (!pool || pool->Info.Strategy != PoolStrategy::Linear)
+			return;
+		std::lock_guard<std::mutex> lock(Mutex);
+		for (auto& block : pool->Blocks)
+			block->Reset();
+		for (size_t index = 0; index < MemoryCategoryCount; ++index) {
+			CategoryTotals[index].AllocationCount -= pool->Categories[index].AllocationCount;
+			CategoryTotals[index].Bytes -= pool->Categories[index].Bytes;
+		}
+		pool->Categories = {};
+	}
+
+	void DeviceMemoryAllocator::CountCategory(const Allocation& allocation, bool add) {
+		auto count = [&allocation, add](CategoryStats& category) {
+			if (add) {
+				++category.AllocationCount;
+				category.Bytes += allocation.Size;
+			} else {
+				--category.AllocationCount;
+				category.Bytes -= allocation.Size;
+			}
+		};
+		size_t index = static_cast<size_t>(allocation.Category);
+		count(CategoryTotals[index]);
+		if (allocation.Pool)
+			count(allocation.Pool->Categories[index]);
+	}
+
+	AllocatorStats DeviceMemoryAllocator::Stats() const {
+		std::lock_guard<std::mutex> lock(Mutex);
+		AllocatorStats stats;
+		stats.MemoryTypes = DedicatedStats;
+		for (auto* pools : { &DefaultPools, &CustomPools })
+			for (auto& pool : *pools)
+				if (pool)
+					for (auto& block : pool->Blocks)
+						block->AddStats(stats.MemoryTypes[pool->Info.MemoryTypeIndex]);
+		for (auto& typeStats : stats.MemoryTypes)
+			stats.Total.Add(typeStats);
+		stats.DeviceMemoryAllocations = DeviceMemoryAllocations;
+
+		auto& memoryProperties = PhysicalDeviceRef.MemoryProperties();
+		stats.Heaps.resize(memoryProperties.memoryHeapCount);
+		for (uint32_t heapIndex = 0; heapIndex < memoryProperties.memoryHeapCount; ++heapIndex) {
+			stats.Heaps[heapIndex].Size = memoryProperties.memoryHeaps[heapIndex].size;
+			HeapBudget(heapIndex, stats.Heaps[heapIndex].Usage, stats.Heaps[heapIndex].Budget);
+		}
+		for (uint32_t index = 0; index < memoryProperties.memoryTypeCount; ++index) {
+			HeapStats& heap = stats.Heaps[memoryProperties.memoryTypes[index].heapIndex];
+			heap.BlockBytes += stats.MemoryTypes[index].BlockBytes;
+			heap.UsedBytes += stats.MemoryTypes[index].UsedBytes;
+		}
+		stats.Categories = CategoryTotals;
+		stats.BudgetFromDriver = BudgetFromDriver;
+		return stats;
+	}
+
+	void DeviceMemoryAllocator::PrintStats(std::ostream& stream) const {
+		AllocatorStats stats = Stats();
+		stream << "Device memory: " << stats.DeviceMemoryAllocations << " VkDeviceMemory object(s), "
+			   << stats.Total.AllocationCount << " allocation(s)" << std::endl;
+		for (uint32_t index = 0; index < static_cast<uint32_t>(stats.MemoryTypes.size()); ++index) {
+			const MemoryTypeStats& typeStats = stats.MemoryTypes[index];
+			if (typeStats.BlockCount == 0)
+				continue;
+			stream << "    type " << index << ": " << typeStats.AllocationCount << " allocation(s) in "
+				   << typeStats.BlockCount << " block(s), " << typeStats.UsedBytes << "/" << typeStats.BlockBytes
+				   << " bytes used, " << typeStats.FreeRangeCount << " free range(s), largest " << typeStats.LargestFreeRange
+				   << ", fragmentation " << typeStats.Fragmentation() << std::endl;
+		}
+		for (uint32_t index = 0; index < static_cast<uint32_t>(stats.Heaps.size()); ++index) {
+			const HeapStats& heap = stats.Heaps[index];
+			stream << "    heap " << index << ": " << heap.UsedBytes << "/" << heap.BlockBytes << " bytes used, "
+				   << heap.Usage << "/" << heap.Budget << " bytes of budget" << (stats.BudgetFromDriver ? "" : " (estimated)") << std::endl;
+		}
+		for (size_t index = 0; index < MemoryCategoryCount; ++index)
+			if (stats.Categories[index].AllocationCount > 0)
+				stream << "    " << MemoryCategoryName(static_cast<MemoryCategory>(index)) << ": "
+					   << stats.Categories[index].AllocationCount << " allocation(s), " << stats.Categories[index].Bytes << " bytes" << std::endl;
+	}
+
+	void DeviceMemoryAllocator::WriteStatsJson(std::ostream& stream) const {
+		AllocatorStats stats = Stats();
+		auto writeTypeStats = [&stream](const MemoryTypeStats& typeStats) {
+			stream << "{\"blockCount\": " << typeStats.BlockCount << ", \"allocationCount\": " << typeStats.AllocationCount
+				   << ", \"blockBytes\": " << typeStats.BlockBytes << ", \"usedBytes\": " << typeStats.UsedBytes
+				   << ", \"freeRangeCount\": " << typeStats.FreeRangeCount << ", \"largestFreeRange\": " << typeStats.LargestFreeRange
+				   << ", \"fragmentation\": " << typeStats.Fragmentation() << "}";
+		};
+
+		stream << "{\n  \"deviceMemoryAllocations\": " << stats.DeviceMemoryAllocations
+			   << ",\n  \"budgetFromDriver\": " << (stats.BudgetFromDriver ? "true" : "false")
+			   << ",\n  \"total\": ";
+		writeTypeStats(stats.Total);
+		stream << ",\n  \"heaps\": [";
+		for (size_t index = 0; index < stats.Heaps.size(); ++index) {
+			const HeapStats& heap = stats.Heaps[index];
+			stream << (index ? "," : "") << "\n    {\"index\": " << index << ", \"size\": " << heap.Size
+				   << ", \"blockBytes\": " << heap.BlockBytes << ", \"usedBytes\": " << heap.UsedBytes
+				   << ", \"usage\": " << heap.Usage << ", \"budget\": " << heap.Budget << "}";
+		}
+		stream << "\n  ],\n  \"memoryTypes\": [";
+		for (size_t index = 0; index < stats.MemoryTypes.size(); ++index) {
+			stream << (index ? "," : "") << "\n    ";
+			writeTypeStats(stats.MemoryTypes[index]);
+		}
+		stream << "\n  ],\n  \"categories\": {";
+		for (size_t index = 0; index < MemoryCategoryCount; ++index)
+			stream << (index ? "," : "") << "\n    \"" << MemoryCategoryName(static_cast<MemoryCategory>(index))
+				   << "\": {\"allocationCount\": " << stats.Categories[index].AllocationCount
+				   << ", \"bytes\": " << stats.Categories[index].Bytes << "}";
+		stream << "\n  }\n}" << std::endl;
+	}
+}
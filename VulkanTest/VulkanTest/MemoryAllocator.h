@@ -0,0 +1,180 @@
+#pragma once
+#include "PhysicalDeviceInfo.h"
+#include <mutex>
+namespace VulkanCookbook {
+	class MemoryBlock;
+	class MemoryPool;
+
+	//Buffers and linear images versus optimal images. When bufferImageGranularity is larger than 1
+	//the two kinds never share a block, so neighbouring sub-allocations never need extra padding.
+	enum class ResourceKind : uint32_t {
+		Linear,
+		Optimal
+	};
+
+	enum class PoolStrategy : uint32_t {
+		Tlsf,	//general purpose, any order of allocation and free
+		Linear	//bump allocation; a block rewinds once everything in it is freed, or on ResetPool
+	};
+
+	//What an allocation holds; Stats reports usage per category.
+	enum class MemoryCategory : uint32_t {
+		Other,
+		Attachment,
+		Texture,
+		Geometry,
+		Staging,
+		Uniform,
+		Count
+	};
+	constexpr size_t MemoryCategoryCount = static_cast<size_t>(MemoryCategory::Count);
+	const char* MemoryCategoryName(MemoryCategory category);
+
+	struct PoolCreateInfo {
+		uint32_t	 MemoryTypeIndex = 0;
+		ResourceKind Kind			 = ResourceKind::Linear;
+		PoolStrategy Strategy		 = PoolStrategy::Tlsf;
+		VkDeviceSize BlockSize		 = 0;	//0 picks the allocator's default for the heap
+		uint32_t	 MaxBlocks		 = 0;	//0 is unlimited
+	};
+
+	//Memory types are ranked as described by MemoryTypePreference. When the best type's heap is
+	//exhausted, the next best type that still has RequiredFlags is tried.
+	struct AllocationCreateInfo {
+		VkMemoryPropertyFlags RequiredFlags	 = 0;
+		VkMemoryPropertyFlags PreferredFlags = 0;
+		VkMemoryPropertyFlags AvoidedFlags	 = 0;
+		ResourceKind		  Kind			 = ResourceKind::Linear;	//ignored by CreateBuffer/CreateImage
+		MemoryPool*			  Pool			 = nullptr;					//overrides the flags and Kind
+		bool				  Dedicated		 = false;					//gets its own VkDeviceMemory
+		MemoryCategory		  Category		 = MemoryCategory::Other;
+	};
+
+	struct Allocation {
+		VkDeviceMemory Memory		   = VK_NULL_HANDLE;
+		VkDeviceSize   Offset		   = 0;
+		VkDeviceSize   Size			   = 0;
+		void*		   Mapped		   = nullptr;	//host-visible blocks stay mapped for their whole lifetime
+		uint32_t	   MemoryTypeIndex = UINT32_MAX;
+	 private:
+		friend class DeviceMemoryAllocator;
+		MemoryPool*	 Pool	 = nullptr;
+		MemoryBlock*   Block	= nullptr;	//null for dedicated allocations
+		uint32_t	   Segment	= 0;
+		MemoryCategory Category = MemoryCategory::Other;
+	};
+
+	struct MemoryTypeStats {
+		uint32_t	 BlockCount		  = 0;
+		uint32_t	 AllocationCount  = 0;
+		VkDeviceSize BlockBytes		  = 0;
+		VkDeviceSize UsedBytes		  = 0;
+		uint32_t	 FreeRangeCount	  = 0;
+		VkDeviceSize LargestFreeRange = 0;
+
+		//0 when all free space in the blocks is one range, approaching 1 as it splinters
+		double Fragmentation() const;
+		void Add(const MemoryTypeStats& other);
+	};
+
+	struct CategoryStats {
+		uint32_t	 AllocationCount = 0;
+		VkDeviceSize Bytes			 = 0;
+	};
+
+	//With VK_EXT_memory_budget, Usage and Budget are the driver's figures for the whole process as of
+	//the last UpdateBudget, plus whatever this allocator allocated or freed since. Without it, Usage is
+	//this allocator's blocks and Budget 80% of the heap.
+	struct HeapStats {
+		VkDeviceSize Size		= 0;
+		VkDeviceSize BlockBytes = 0;	//VkDeviceMemory owned by this allocator
+		VkDeviceSize UsedBytes	= 0;	//handed out to allocations
+		VkDeviceSize Usage		= 0;
+		VkDeviceSize Budget		= 0;
+	};
+
+	struct AllocatorStats {
+		std::vector<MemoryTypeStats>					 MemoryTypes;
+		std::vector<HeapStats>							 Heaps;
+		std::array<CategoryStats, MemoryCategoryCount>	 Categories;
+		MemoryTypeStats									 Total;
+		uint32_t										 DeviceMemoryAllocations = 0;	//live vkAllocateMemory calls
+		bool											 BudgetFromDriver		 = false;
+	};
+
+	//Reserves large blocks per memory type and sub-allocates them with a two-level segregated fit
+	//(TLSF) scheme, so allocation and free are O(1) and the number of VkDeviceMemory objects stays
+	//far below maxMemoryAllocationCount. Requests larger than half a block get dedicated memory.
+	//Device memory is never allocated past a heap's budget; the next best memory type is tried instead.
+	//All calls are serialised by one mutex.
+	class DeviceMemoryAllocator {
+	 public:
+		DeviceMemoryAllocator(const LogicalDevice& logicalDevice, const PhysicalDeviceInfo& deviceInfo, VkDeviceSize preferredBlockSize = 0);
+		~DeviceMemoryAllocator();
+		DeviceMemoryAllocator(const DeviceMemoryAllocator&) = delete;
+		DeviceMemoryAllocator& operator=(const DeviceMemoryAllocator&) = delete;
+
+		bool Allocate(const VkMemoryRequirements& requirements, const AllocationCreateInfo& createInfo, Allocation& allocation);
+		void Free(Allocation& allocation);
+
+		bool CreateBuffer(const VkBufferCreateInfo& bufferInfo, const AllocationCreateInfo& createInfo, VkBuffer& buffer, Allocation& allocation);
+		bool CreateImage(const VkImageCreateInfo& imageInfo, const AllocationCreateInfo& createInfo, VkImage& image, Allocation& allocation);
+		void DestroyBuffer(VkBuffer& buffer, Allocation& allocation);
+		void DestroyImage(VkImage& image, Allocation& allocation);
+		//Copies into a mapped allocation and flushes the range when the memory is not host-coherent.
+		//The GPU must not be using that range.
+		bool Write(const Allocation& allocation, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+
+		MemoryPool* CreatePool(const PoolCreateInfo& createInfo);
+		//Every allocation from the pool must have been freed (or the pool reset) beforehand.
+		void DestroyPool(MemoryPool*& pool);
+		//Linear pools only: drops every allocation at once. The dropped allocations are gone from the stats
+		//and must not be freed afterwards.
+		void ResetPool(MemoryPool* pool);
+
+		const LogicalDevice&	  Device() const	 { return LogicalDeviceRef; }
+		const PhysicalDeviceInfo& DeviceInfo() const { return PhysicalDeviceRef; }
+
+		//Defragmentation support. AllocateForMove finds room for a copy of a live allocation in a fuller
+		//block of the same pool, without allocating device memory. It fails for dedicated and linear-pool
+		//allocations and when no fuller block has room. Occupancy is the used fraction of the allocation's
+		//block (1 for dedicated memory).
+		bool AllocateForMove(const Allocation& source, const VkMemoryRequirements& requirements, Allocation& destination);
+		double Occupancy(const Allocation& allocation) const;
+		//Frees every empty block, including the one each pool otherwise keeps in reserve.
+		void TrimEmptyBlocks();
+
+		//Re-reads the heap budgets from VK_EXT_memory_budget, if supported. Call once per frame.
+		void UpdateBudget();
+		AllocatorStats Stats() const;
+		void PrintStats(std::ostream& stream = std::cout) const;
+		void WriteStatsJson(std::ostream& stream) const;
+	 private:
+		bool AllocateFromPool(MemoryPool& pool, const VkMemoryRequirements& requirements, Allocation& allocation);
+		bool AllocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, Allocation& allocation);
+		bool AllocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory& memory, void*& mapped);
+		void FreeDeviceMemory(VkDeviceMemory& memory, uint32_t memoryTypeIndex, VkDeviceSize size);
+		void HeapBudget(uint32_t heapIndex, VkDeviceSize& usage, VkDeviceSize& budget) const;
+		void ReleaseEmptyBlocks(MemoryPool& pool, bool keepOne = true);
+		VkDeviceSize DefaultBlockSize(uint32_t memoryTypeIndex) const;
+		MemoryPool& DefaultPool(uint32_t memoryTypeIndex, ResourceKind kind);
+		//Counts allocation in or out of CategoryTotals and of its pool's share of them.
+		void CountCategory(const Allocation& allocation, bool add);
+
+		const LogicalDevice&					 LogicalDeviceRef;
+		const PhysicalDeviceInfo&				 PhysicalDeviceRef;
+		VkDeviceSize							 PreferredBlockSize;
+		bool									 SeparateResourceKinds;
+		mutable std::mutex						 Mutex;
+		std::vector<std::unique_ptr<MemoryPool>> DefaultPools;	//[memoryTypeIndex * 2 + kind], created on first use
+		std::vector<std::unique_ptr<MemoryPool>> CustomPools;
+		std::vector<MemoryTypeStats>			 DedicatedStats;
+		uint32_t								 DeviceMemoryAllocations = 0;
+		std::vector<VkDeviceSize>				 HeapBlockBytes;
+		std::vector<VkDeviceSize>				 HeapBlockBytesAtUpdate;	//HeapBlockBytes when the driver's figures were read
+		std::vector<VkDeviceSize>				 DriverHeapUsage;
+		std::vector<VkDeviceSize>				 DriverHeapBudget;
+		bool									 BudgetFromDriver		 = false;
+		std::array<CategoryStats, MemoryCategoryCount> CategoryTotals;
+	};
+}
@@ -0,0 +1,234 @@
+#include "MemoryBlock.h"
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+namespace VulkanCookbook {
+	namespace {
+		uint32_t MostSignificantBit(uint64_t value) {
+		#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return index;
+		#else
+			return 63 - __builtin_clzll(value);
+		#endif
+		}
+
+		uint32_t LeastSignificantBit(uint64_t value) {
+		#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward64(&index, value);
+			return index;
+		#else
+			return __builtin_ctzll(value);
+		#endif
+		}
+
+		VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+			return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+		}
+	}
+
+	MemoryBlock::MemoryBlock(VkDeviceMemory memory, VkDeviceSize size, void* mapped, PoolStrategy strategy)
+		: Memory(memory), Size(size), Mapped(mapped), Strategy(strategy) {
+		for (auto& heads : FreeHeads)
+			heads.fill(NullIndex);
+		if (Strategy == PoolStrategy::Tlsf) {
+			First = NewSegment({ 0, Size, NullIndex, NullIndex, NullIndex, NullIndex, true });
+			InsertFree(First);
+		}
+	}
+
+	bool MemoryBlock::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& segment) {
+		if (Strategy == PoolStrategy::Linear) {
+			offset = AlignUp(Head, alignment);
+			if (offset + size > Size)
+				return false;
+			Head = offset + size;
+			Used += size;
+			++AllocationCount;
+			segment = 0;
+			return true;
+		}
+
+		uint32_t index = FindFree(size, alignment);
+		if (index == NullIndex)
+			return false;
+		RemoveFree(index);
+
+		VkDeviceSize padding = AlignUp(Segments[index].Offset, alignment) - Segments[index].Offset;
+		if (padding > 0) {
+			uint32_t front = NewSegment({ Segments[index].Offset, padding, Segments[index].PrevPhysical, index, NullIndex, NullIndex, true });
+			if (Segments[front].PrevPhysical != NullIndex)
+				Segments[Segments[front].PrevPhysical].NextPhysical = front;
+			else
+				First = front;
+			Segments[index].PrevPhysical = front;
+			Segments[index].Offset += padding;
+			Segments[index].Size -= padding;
+			InsertFree(front);
+		}
+		if (Segments[index].Size > size) {
+			uint32_t back = NewSegment({ Segments[index].Offset + size, Segments[index].Size - size, index,
+										 Segments[index].NextPhysical, NullIndex, NullIndex, true });
+			if (Segments[back].NextPhysical != NullIndex)
+				Segments[Segments[back].NextPhysical].PrevPhysical = back;
+			Segments[index].NextPhysical = back;
+			Segments[index].Size = size;
+			InsertFree(back);
+		}
+		Segments[index].Free = false;
+		Used += size;
+		++AllocationCount;
+		offset = Segments[index].Offset;
+		segment = index;
+		return true;
+	}
+
+	void MemoryBlock::Free(uint32_t segment, VkDeviceSize size) {
+		Used -= size;
+		--AllocationCount;
+		if (Strategy == PoolStrategy::Linear) {
+			if (AllocationCount == 0)
+				Head = 0;
+			return;
+		}
+
+		Segments[segment].Free = true;
+		if (uint32_t next = Segments[segment].NextPhysical; next != NullIndex && Segments[next].Free) {
+			RemoveFree(next);
+			Segments[segment].Size += Segments[next].Size;
+			Unlink(next);
+		}
+		if (uint32_t previous = Segments[segment].PrevPhysical; previous != NullIndex && Segments[previous].Free) {
+			RemoveFree(previous);
+			Segments[previous].Size += Segments[segment].Size;
+			Unlink(segment);
+			segment = previous;
+		}
+		InsertFree(segment);
+	}
+
+	void MemoryBlock::Reset() {
+		Head = 0;
+		Used = 0;
+		AllocationCount = 0;
+	}
+
+	void MemoryBlock::AddStats(MemoryTypeStats& stats) const {
+		++stats.BlockCount;
+		stats.AllocationCount += AllocationCount;
+		stats.BlockBytes += Size;
+		stats.UsedBytes += Used;
+		auto addFreeRange = [&stats](VkDeviceSize size) {
+			++stats.FreeRangeCount;
+			stats.LargestFreeRange = std::max(stats.LargestFreeRange, size);
+		};
+		if (Strategy == PoolStrategy::Linear) {
+			if (Head < Size)
+				addFreeRange(Size - Head);
+			return;
+		}
+		for (uint32_t index = First; index != NullIndex; index = Segments[index].NextPhysical)
+			if (Segments[index].Free)
+				addFreeRange(Segments[index].Size);
+	}
+
+	void MemoryBlock::Mapping(VkDeviceSize size, uint32_t& firstLevel, uint32_t& secondLevel) {
+		if (size < SmallSize) {
+			firstLevel = 0;
+			secondLevel = static_cast<uint32_t>(size / (SmallSize / SecondLevelCount));
+		}
+		else {
+			uint32_t bit = MostSignificantBit(size);
+			firstLevel = bit - FirstLevelShift + 1;
+			secondLevel = static_cast<uint32_t>(size >> (bit - SecondLevelBits)) - SecondLevelCount;
+		}
+	}
+
+	//Searches for size + alignment - 1 rounded up to the next class boundary, so that any range in
+	//the class found fits once aligned; the small classes are SmallSize / SecondLevelCount wide.
+	//Only when no such class has a range is the request's own class searched range by range;
+	//otherwise a block filled with equal-sized requests would never reuse its last free range.
+	uint32_t MemoryBlock::FindFree(VkDeviceSize size, VkDeviceSize alignment) const {
+		VkDeviceSize rounded = size + (alignment > 1 ? alignment - 1 : 0);
+		rounded += rounded < SmallSize ? SmallSize / SecondLevelCount - 1
+									   : (1ull << (MostSignificantBit(rounded) - SecondLevelBits)) - 1;
+		uint32_t firstLevel, secondLevel;
+		Mapping(rounded, firstLevel, secondLevel);
+		if (firstLevel < FirstLevelCount) {
+			uint32_t secondLevelMap = SecondLevelMaps[firstLevel] & (~0u << secondLevel);
+			if (secondLevelMap == 0) {
+				uint64_t firstLevelMap = firstLevel + 1 < 64 ? FirstLevelMap & (~0ull << (firstLevel + 1)) : 0;
+				if (firstLevelMap != 0) {
+					firstLevel = LeastSignificantBit(firstLevelMap);
+					secondLevelMap = SecondLevelMaps[firstLevel];
+				}
+			}
+			if (secondLevelMap != 0)
+				return FreeHeads[firstLevel][LeastSignificantBit(secondLevelMap)];
+		}
+
+		Mapping(size, firstLevel, secondLevel);
+		if (firstLevel >= FirstLevelCount)
+			return NullIndex;
+		for (uint32_t index = FreeHeads[firstLevel][secondLevel]; index != NullIndex; index = Segments[index].NextFree)
+			if (AlignUp(Segments[index].Offset, alignment) - Segments[index].Offset + size <= Segments[index].Size)
+				return index;
+		return NullIndex;
+	}
+
+	void MemoryBlock::InsertFree(uint32_t index) {
+		uint32_t firstLevel, secondLevel;
+		Mapping(Segments[index].Size, firstLevel, secondLevel);
+		uint32_t head = FreeHeads[firstLevel][secondLevel];
+		Segments[index].Free = true;
+		Segments[index].PrevFree = NullIndex;
+		Segments[index].NextFree = head;
+		if (head != NullIndex)
+			Segments[head].PrevFree = index;
+		FreeHeads[firstLevel][secondLevel] = index;
+		FirstLevelMap |= 1ull << firstLevel;
+		SecondLevelMaps[firstLevel] |= 1u << secondLevel;
+	}
+
+	void MemoryBlock::RemoveFree(uint32_t index) {
+		uint32_t firstLevel, secondLevel;
+		Mapping(Segments[index].Size, firstLevel, secondLevel);
+		Segment& segment = Segments[index];
+		if (segment.PrevFree != NullIndex)
+			Segments[segment.PrevFree].NextFree = segment.NextFree;
+		else
+			FreeHeads[firstLevel][secondLevel] = segment.NextFree;
+		if (segment.NextFree != NullIndex)
+			Segments[segment.NextFree].PrevFree = segment.PrevFree;
+		if (FreeHeads[firstLevel][secondLevel] == NullIndex) {
+			SecondLevelMaps[firstLevel] &= ~(1u << secondLevel);
+			if (SecondLevelMaps[firstLevel] == 0)
+				FirstLevelMap &= ~(1ull << firstLevel);
+		}
+	}
+
+	uint32_t MemoryBlock::NewSegment(const Segment& segment) {
+		if (!UnusedSegments.empty()) {
+			uint32_t index = UnusedSegments.back();
+			UnusedSegments.pop_back();
+			Segments[index] = segment;
+			return index;
+		}
+		Segments.push_back(segment);
+		return static_cast<uint32_t>(Segments.size() - 1);
+	}
+
+	void MemoryBlock::Unlink(uint32_t index) {
+		Segment& segment = Segments[index];
+		if (segment.PrevPhysical != NullIndex)
+			Segments[segment.PrevPhysical].NextPhysical = segment.NextPhysical;
+		else
+			First = segment.NextPhysical;
+		if (segment.NextPhysical != NullIndex)
+			Segments[segment.NextPhysical].PrevPhysical = segment.PrevPhysical;
+		UnusedSegments.push_back(index);
+	}
+}
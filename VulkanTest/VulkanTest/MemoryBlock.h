@@ -0,0 +1,60 @@
+#pragma once
+#include "MemoryAllocator.h"
+namespace VulkanCookbook {
+	//One VkDeviceMemory. TLSF blocks keep every range, used or free, in a physical list;
+	//free ranges are also bucketed by size: the first level by power of two, the second
+	//level splits each power of two linearly into SecondLevelCount classes.
+	//Only does the bookkeeping, so it also works on a VK_NULL_HANDLE memory.
+	class MemoryBlock {
+	 public:
+		MemoryBlock(VkDeviceMemory memory, VkDeviceSize size, void* mapped, PoolStrategy strategy);
+
+		bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& segment);
+		void Free(uint32_t segment, VkDeviceSize size);
+		void Reset();
+
+		bool Empty() const { return AllocationCount == 0; }
+		VkDeviceSize UsedBytes() const { return Used; }
+		void AddStats(MemoryTypeStats& stats) const;
+
+		VkDeviceMemory Memory;
+		VkDeviceSize   Size;
+		void*		   Mapped;
+	 private:
+		static constexpr uint32_t NullIndex		   = UINT32_MAX;
+		static constexpr uint32_t SecondLevelBits  = 5;
+		static constexpr uint32_t SecondLevelCount = 1u << SecondLevelBits;
+		static constexpr uint32_t FirstLevelShift  = SecondLevelBits + 2;
+		static constexpr uint64_t SmallSize		   = 1ull << FirstLevelShift;	//sizes below this share the first level 0
+		static constexpr uint32_t FirstLevelCount  = 64 - FirstLevelShift + 1;
+
+		struct Segment {
+			VkDeviceSize Offset;
+			VkDeviceSize Size;
+			uint32_t	 PrevPhysical;
+			uint32_t	 NextPhysical;
+			uint32_t	 PrevFree;
+			uint32_t	 NextFree;
+			bool		 Free;
+		};
+
+		static void Mapping(VkDeviceSize size, uint32_t& firstLevel, uint32_t& secondLevel);
+		uint32_t FindFree(VkDeviceSize size, VkDeviceSize alignment) const;
+		void InsertFree(uint32_t index);
+		void RemoveFree(uint32_t index);
+		uint32_t NewSegment(const Segment& segment);
+		//Removes a range from the physical list after its neighbour absorbed it.
+		void Unlink(uint32_t index);
+
+		PoolStrategy														Strategy;
+		VkDeviceSize														Head			= 0;
+		VkDeviceSize														Used			= 0;
+		uint32_t															AllocationCount = 0;
+		uint32_t															First			= NullIndex;
+		std::vector<Segment>												Segments;
+		std::vector<uint32_t>												UnusedSegments;
+		uint64_t															FirstLevelMap	= 0;
+		std::array<uint32_t, FirstLevelCount>								SecondLevelMaps = {};
+		std::array<std::array<uint32_t, SecondLevelCount>, FirstLevelCount> FreeHeads;
+	};
+}
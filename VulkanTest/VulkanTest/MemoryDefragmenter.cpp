@@ -0,0 +1,372 @@
+#include "MemoryDefragmenter.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	bool MemoryDefragmenter::Create(DeviceMemoryAllocator& allocator, VkQueue queue, uint32_t queueFamilyIndex, FrameTimeline& timeline,
+									const DefragmentationSettings& settings) {
+		auto& device = allocator.Device();
+		VkCommandPoolCreateInfo poolInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,									//sType
+			nullptr,																	//pNext
+			VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,	//flags
+			queueFamilyIndex															//queueFamilyIndex
+		};
+		if (device.Dispatch.vkCreateCommandPool(device.Handle, &poolInfo, device.HostCallbacks, &CommandPool) != VK_SUCCESS) {
+			std::cout << "Could not create a command pool for the defragmenter." << std::endl;
+			return false;
+		}
+		VkCommandBufferAllocateInfo allocateInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,	//sType
+			nullptr,										//pNext
+			CommandPool,									//commandPool
+			VK_COMMAND_BUFFER_LEVEL_PRIMARY,				//level
+			1												//commandBufferCount
+		};
+		VkFenceCreateInfo fenceInfo = {
+			VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,	//sType
+			nullptr,								//pNext
+			0										//flags
+		};
+		if (device.Dispatch.vkAllocateCommandBuffers(device.Handle, &allocateInfo, &CommandBuffer) != VK_SUCCESS ||
+			device.Dispatch.vkCreateFence(device.Handle, &fenceInfo, device.HostCallbacks, &Fence) != VK_SUCCESS) {
+			std::cout << "Could not create the defragmenter's command buffer." << std::endl;
+			device.Dispatch.vkDestroyCommandPool(device.Handle, CommandPool, device.HostCallbacks);
+			CommandPool = VK_NULL_HANDLE;
+			return false;
+		}
+		Allocator = &allocator;
+		Queue = queue;
+		Timeline = &timeline;
+		Settings = settings;
+		PassInFlight = false;
+		return true;
+	}
+
+	void MemoryDefragmenter::Destroy() {
+		if (!Allocator)
+			return;
+		auto& device = Allocator->Device();
+		if (PassInFlight) {
+			device.Dispatch.vkWaitForFences(device.Handle, 1, &Fence, VK_TRUE, UINT64_MAX);
+			for (auto& move : Moves)
+				Retire(move.Buffer, move.Image, move.Memory);
+			Moves.clear();
+			PassInFlight = false;
+		}
+		for (auto& entry : Resources)
+			if (entry.Live)
+				Retire(entry.Public.Buffer, entry.Public.Image, entry.Public.Memory);
+		Resources.clear();
+		UnusedHandles.clear();
+		DestroyRetired(true);
+
+		device.Dispatch.vkDestroyFence(device.Handle, Fence, device.HostCallbacks);
+		//destroying the pool frees its command buffer
+		device.Dispatch.vkDestroyCommandPool(device.Handle, CommandPool, device.HostCallbacks);
+		Fence = VK_NULL_HANDLE;
+		CommandPool = VK_NULL_HANDLE;
+		CommandBuffer = VK_NULL_HANDLE;
+		Allocator = nullptr;
+		Timeline = nullptr;
+	}
+
+	bool MemoryDefragmenter::Register(Entry&& entry, uint32_t& handle) {
+		entry.Live = true;
+		if (!UnusedHandles.empty()) {
+			handle = UnusedHandles.back();
+			UnusedHandles.pop_back();
+			Resources[handle] = std::move(entry);
+		}
+		else {
+			handle = static_cast<uint32_t>(Resources.size());
+			Resources.push_back(std::move(entry));
+		}
+		Entry& stored = Resources[handle];
+		//the vector's storage moved with it, so the pointer is set only now
+		stored.BufferInfo.pQueueFamilyIndices = stored.QueueFamilyIndices.data();
+		stored.ImageInfo.pQueueFamilyIndices = stored.QueueFamilyIndices.data();
+		return true;
+	}
+
+	bool MemoryDefragmenter::RegisterBuffer(const VkBufferCreateInfo& bufferInfo, VkBuffer buffer, const Allocation& memory,
+											MovedCallback onMoved, uint32_t& handle) {
+		const VkBufferUsageFlags copyUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		if ((bufferInfo.usage & copyUsage) != copyUsage) {
+			std::cout << "Movable buffers need TRANSFER_SRC and TRANSFER_DST usage." << std::endl;
+			return false;
+		}
+		auto& device = Allocator->Device();
+		Entry entry;
+		entry.Public.Buffer = buffer;
+		entry.Public.Memory = memory;
+		entry.BufferInfo = bufferInfo;
+		entry.BufferInfo.pNext = nullptr;
+		entry.QueueFamilyIndices.assign(bufferInfo.pQueueFamilyIndices, bufferInfo.pQueueFamilyIndices + bufferInfo.queueFamilyIndexCount);
+		device.Dispatch.vkGetBufferMemoryRequirements(device.Handle, buffer, &entry.Requirements);
+		entry.OnMoved = std::move(onMoved);
+		return Register(std::move(entry), handle);
+	}
+
+	bool MemoryDefragmenter::RegisterImage(const VkImageCreateInfo& imageInfo, VkImage image, const Allocation& memory,
+										   VkImageLayout layout, VkImageAspectFlags aspect, MovedCallback onMoved, uint32_t& handle) {
+		const VkImageUsageFlags copyUsage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		if ((imageInfo.usage & copyUsage) != copyUsage) {
+			std::cout << "Movable images need TRANSFER_SRC and TRANSFER_DST usage." << std::endl;
+			return false;
+		}
+		auto& device = Allocator->Device();
+		Entry entry;
+		entry.Public.Image = image;
+		entry.Public.Memory = memory;
+		entry.ImageInfo = imageInfo;
+		entry.ImageInfo.pNext = nullptr;
+		entry.ImageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		entry.QueueFamilyIndices.assign(imageInfo.pQueueFamilyIndices, imageInfo.pQueueFamilyIndices + imageInfo.queueFamilyIndexCount);
+		entry.Layout = layout;
+		entry.Aspect = aspect;
+		device.Dispatch.vkGetImageMemoryRequirements(device.Handle, image, &entry.Requirements);
+		entry.OnMoved = std::move(onMoved);
+		return Register(std::move(entry), handle);
+	}
+
+	void MemoryDefragmenter::Release(uint32_t handle) {
+		Entry& entry = Resources[handle];
+		if (!entry.Live)
+			return;
+		if (entry.Moving) {
+			entry.Released = true;
+			return;
+		}
+		Retire(entry.Public.Buffer, entry.Public.Image, entry.Public.Memory);
+		entry = Entry();
+		UnusedHandles.push_back(handle);
+	}
+
+	void MemoryDefragmenter::Retire(VkBuffer buffer, VkImage image, const Allocation& memory) {
+		//the frames before the current one may still use it, and the current one may have been recorded with it
+		RetiredResources.push_back({ buffer, image, memory, Timeline->CurrentFrame() });
+	}
+
+	void MemoryDefragmenter::DestroyRetired(bool all) {
+		bool destroyed = false;
+		while (!RetiredResources.empty() && (all || Timeline->IsComplete(RetiredResources.front().Frame))) {
+			Retired& retired = RetiredResources.front();
+			if (retired.Buffer)
+				Allocator->DestroyBuffer(retired.Buffer, retired.Memory);
+			else
+				Allocator->DestroyImage(retired.Image, retired.Memory);
+			RetiredResources.pop_front();
+			destroyed = true;
+		}
+		if (destroyed)
+			Allocator->TrimEmptyBlocks();
+	}
+
+	bool MemoryDefragmenter::Step() {
+		if (PassInFlight) {
+			auto& device = Allocator->Device();
+			if (device.Dispatch.vkGetFenceStatus(device.Handle, Fence) != VK_SUCCESS) {
+				DestroyRetired(false);
+				return true;
+			}
+			FinishPass();
+		}
+		DestroyRetired(false);
+		return BeginPass();
+	}
+
+	void MemoryDefragmenter::FinishPass() {
+		for (auto& move : Moves) {
+			Entry& entry = Resources[move.Handle];
+			entry.Moving = false;
+			Retire(entry.Public.Buffer, entry.Public.Image, entry.Public.Memory);
+			if (entry.Released) {
+				Retire(move.Buffer, move.Image, move.Memory);
+				entry = Entry();
+				UnusedHandles.push_back(move.Handle);
+				continue;
+			}
+			entry.Public.Buffer = move.Buffer;
+			entry.Public.Image = move.Image;
+			entry.Public.Memory = move.Memory;
+			++entry.Public.Version;
+			if (entry.OnMoved)
+				entry.OnMoved(move.Handle, entry.Public);
+		}
+		Moves.clear();
+		PassInFlight = false;
+	}
+
+	bool MemoryDefragmenter::CreateCopy(const Entry& entry, Move& move) {
+		auto& device = Allocator->Device();
+		auto& dispatch = device.Dispatch;
+		//room is found before anything is created, so resources that cannot move cost nothing
+		if (!Allocator->AllocateForMove(entry.Public.Memory, entry.Requirements, move.Memory))
+			return false;
+		move.Buffer = VK_NULL_HANDLE;
+		move.Image = VK_NULL_HANDLE;
+		VkResult result;
+		if (entry.Public.Buffer) {
+			result = dispatch.vkCreateBuffer(device.Handle, &entry.BufferInfo, device.HostCallbacks, &move.Buffer);
+			if (result == VK_SUCCESS)
+				result = dispatch.vkBindBufferMemory(device.Handle, move.Buffer, move.Memory.Memory, move.Memory.Offset);
+		}
+		else {
+			result = dispatch.vkCreateImage(device.Handle, &entry.ImageInfo, device.HostCallbacks, &move.Image);
+			if (result == VK_SUCCESS)
+				result = dispatch.vkBindImageMemory(device.Handle, move.Image, move.Memory.Memory, move.Memory.Offset);
+		}
+		if (result != VK_SUCCESS) {
+			std::cout << "Could not create a copy of a resource to move." << std::endl;
+			if (entry.Public.Buffer)
+				Allocator->DestroyBuffer(move.Buffer, move.Memory);
+			else
+				Allocator->DestroyImage(move.Image, move.Memory);
+			return false;
+		}
+		return true;
+	}
+
+	bool MemoryDefragmenter::BeginPass() {
+		//resources in the emptiest blocks go first, so those blocks drain and can be freed
+		std::vector<std::pair<double, uint32_t>> candidates;
+		for (uint32_t handle = 0; handle < static_cast<uint32_t>(Resources.size()); ++handle) {
+			const Entry& entry = Resources[handle];
+			if (!entry.Live || entry.Released)
+				continue;
+			double occupancy = Allocator->Occupancy(entry.Public.Memory);
+			if (occupancy < Settings.MaxSourceOccupancy)
+				candidates.emplace_back(occupancy, handle);
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		VkDeviceSize bytes = 0;
+		for (auto& candidate : candidates) {
+			if (Moves.size() >= Settings.MovesPerStep)
+				break;
+			Entry& entry = Resources[candidate.second];
+			if (bytes + entry.Public.Memory.Size > Settings.BytesPerStep)
+				continue;
+			Move move;
+			move.Handle = candidate.second;
+			if (!CreateCopy(entry, move))
+				continue;
+			Moves.push_back(move);
+			entry.Moving = true;
+			bytes += entry.Public.Memory.Size;
+		}
+		if (Moves.empty())
+			return true;
+
+		auto& device = Allocator->Device();
+		auto& dispatch = device.Dispatch;
+		dispatch.vkResetFences(device.Handle, 1, &Fence);
+		dispatch.vkResetCommandBuffer(CommandBuffer, 0);
+		VkCommandBufferBeginInfo beginInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,	//sType
+			nullptr,										//pNext
+			VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,	//flags
+			nullptr											//pInheritanceInfo
+		};
+		dispatch.vkBeginCommandBuffer(CommandBuffer, &beginInfo);
+
+		std::vector<VkImageMemoryBarrier> before, after;
+		auto imageBarrier = [](VkImage image, VkImageAspectFlags aspect, const VkImageCreateInfo& info, VkAccessFlags srcAccess,
+							   VkAccessFlags dstAccess, VkImageLayout oldLayout, VkImageLayout newLayout) {
+			return VkImageMemoryBarrier{
+				VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,									//sType
+				nullptr,																//pNext
+				srcAccess,																//srcAccessMask
+				dstAccess,																//dstAccessMask
+				oldLayout,																//oldLayout
+				newLayout,																//newLayout
+				VK_QUEUE_FAMILY_IGNORED,												//srcQueueFamilyIndex
+				VK_QUEUE_FAMILY_IGNORED,												//dstQueueFamilyIndex
+				image,																	//image
+				{ aspect, 0, info.mipLevels, 0, info.arrayLayers }						//subresourceRange
+			};
+		};
+		for (auto& move : Moves) {
+			const Entry& entry = Resources[move.Handle];
+			if (!move.Image)
+				continue;
+			before.push_back(imageBarrier(entry.Public.Image, entry.Aspect, entry.ImageInfo, VK_ACCESS_MEMORY_WRITE_BIT,
+										  VK_ACCESS_TRANSFER_READ_BIT, entry.Layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL));
+			before.push_back(imageBarrier(move.Image, entry.Aspect, entry.ImageInfo, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+										  VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+			//frames recorded before the switch keep using the old image, in its usual layout
+			after.push_back(imageBarrier(entry.Public.Image, entry.Aspect, entry.ImageInfo, 0, VK_ACCESS_MEMORY_READ_BIT,
+										 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, entry.Layout));
+			after.push_back(imageBarrier(move.Image, entry.Aspect, entry.ImageInfo, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT,
+										 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, entry.Layout));
+		}
+		VkMemoryBarrier readAfterWrite = {
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER,	//sType
+			nullptr,							//pNext
+			VK_ACCESS_MEMORY_WRITE_BIT,			//srcAccessMask
+			VK_ACCESS_TRANSFER_READ_BIT			//dstAccessMask
+		};
+		dispatch.vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+									  1, &readAfterWrite, 0, nullptr, static_cast<uint32_t>(before.size()), before.data());
+
+		std::vector<VkImageCopy> regions;
+		for (auto& move : Moves) {
+			const Entry& entry = Resources[move.Handle];
+			if (move.Buffer) {
+				VkBufferCopy region = { 0, 0, entry.BufferInfo.size };
+				dispatch.vkCmdCopyBuffer(CommandBuffer, entry.Public.Buffer, move.Buffer, 1, &region);
+				continue;
+			}
+			regions.clear();
+			for (uint32_t mipLevel = 0; mipLevel < entry.ImageInfo.mipLevels; ++mipLevel) {
+				VkImageSubresourceLayers subresource = { entry.Aspect, mipLevel, 0, entry.ImageInfo.arrayLayers };
+				VkExtent3D extent = {
+					std::max(entry.ImageInfo.extent.width >> mipLevel, 1u),
+					std::max(entry.ImageInfo.extent.height >> mipLevel, 1u),
+					std::max(entry.ImageInfo.extent.depth >> mipLevel, 1u)
+				};
+				regions.push_back({ subresource, { 0, 0, 0 }, subresource, { 0, 0, 0 }, extent });
+			}
+			dispatch.vkCmdCopyImage(CommandBuffer, entry.Public.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, move.Image,
+									VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+		}
+
+		VkMemoryBarrier visibility = {
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER,	//sType
+			nullptr,							//pNext
+			VK_ACCESS_TRANSFER_WRITE_BIT,		//srcAccessMask
+			VK_ACCESS_MEMORY_READ_BIT			//dstAccessMask
+		};
+		dispatch.vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+									  1, &visibility, 0, nullptr, static_cast<uint32_t>(after.size()), after.data());
+		dispatch.vkEndCommandBuffer(CommandBuffer);
+
+		VkSubmitInfo submitInfo = {
+			VK_STRUCTURE_TYPE_SUBMIT_INFO,	//sType
+			nullptr,						//pNext
+			0,								//waitSemaphoreCount
+			nullptr,						//pWaitSemaphores
+			nullptr,						//pWaitDstStageMask
+			1,								//commandBufferCount
+			&CommandBuffer,					//pCommandBuffers
+			0,								//signalSemaphoreCount
+			nullptr							//pSignalSemaphores
+		};
+		if (dispatch.vkQueueSubmit(Queue, 1, &submitInfo, Fence) != VK_SUCCESS) {
+			std::cout << "Could not submit defragmentation copies." << std::endl;
+			for (auto& move : Moves) {
+				Entry& entry = Resources[move.Handle];
+				entry.Moving = false;
+				Retire(move.Buffer, move.Image, move.Memory);
+				if (entry.Released) {
+					Retire(entry.Public.Buffer, entry.Public.Image, entry.Public.Memory);
+					entry = Entry();
+					UnusedHandles.push_back(move.Handle);
+				}
+			}
+			Moves.clear();
+			return false;
+		}
+		PassInFlight = true;
+		return true;
+	}
+}
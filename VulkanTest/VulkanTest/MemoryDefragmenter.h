@@ -0,0 +1,100 @@
+#pragma once
+#include "MemoryAllocator.h"
+#include "FrameTimeline.h"
+#include <deque>
+namespace VulkanCookbook {
+	struct DefragmentationSettings {
+		VkDeviceSize BytesPerStep		= 16ull * 1024 * 1024;	//copy budget of one Step
+		uint32_t	 MovesPerStep		= 64;
+		double		 MaxSourceOccupancy = 0.75;	//fuller blocks are left alone
+	};
+
+	//What users of a registered resource see. Buffer/Image change when the resource is moved, so they
+	//are looked up through the handle whenever commands or descriptors are built; Version counts moves.
+	struct MovableResource {
+		VkBuffer   Buffer  = VK_NULL_HANDLE;
+		VkImage	   Image   = VK_NULL_HANDLE;
+		Allocation Memory;
+		uint32_t   Version = 0;
+	};
+
+	//Compacts long-lived resources incrementally. Every Step moves a few resources from sparsely used
+	//blocks into fuller ones with GPU copies, within a per-Step byte budget. Once the copies have
+	//finished, the handle is pointed at the new buffer/image and OnMoved is called. The old one is
+	//destroyed once the timeline's frame that was current at the switch is complete, and empty blocks
+	//are given back to the driver.
+	//Copies run on the queue given to Create. Images must be used on that queue, as a move takes the old
+	//image out of its layout for the copy; buffers may be used on other queues too, if they are shared
+	//concurrently with its family and nothing is still writing them when Step runs. Only resources the
+	//GPU does not write (meshes, textures) may be registered; they need TRANSFER_SRC and TRANSFER_DST usage.
+	class MemoryDefragmenter {
+	 public:
+		using MovedCallback = std::function<void(uint32_t handle, const MovableResource& resource)>;
+
+		//timeline numbers the frames that use the resources; it need not have been created yet.
+		bool Create(DeviceMemoryAllocator& allocator, VkQueue queue, uint32_t queueFamilyIndex, FrameTimeline& timeline,
+					const DefragmentationSettings& settings = DefragmentationSettings());
+		//Waits for a pass in flight and destroys every registered resource.
+		void Destroy();
+
+		//The defragmenter takes ownership of the buffer/image and its memory. Copies are created from the
+		//create info without its pNext chain.
+		bool RegisterBuffer(const VkBufferCreateInfo& bufferInfo, VkBuffer buffer, const Allocation& memory,
+							MovedCallback onMoved, uint32_t& handle);
+		//layout is the one the image stays in between moves; copies return it to that layout.
+		bool RegisterImage(const VkImageCreateInfo& imageInfo, VkImage image, const Allocation& memory, VkImageLayout layout,
+						   VkImageAspectFlags aspect, MovedCallback onMoved, uint32_t& handle);
+		//Destroyed once the current frame is complete, or by Destroy.
+		void Release(uint32_t handle);
+		const MovableResource& Get(uint32_t handle) const { return Resources[handle].Public; }
+
+		//Call once per frame after the frame's fence wait.
+		bool Step();
+	 private:
+		struct Entry {
+			MovableResource		  Public;
+			VkBufferCreateInfo	  BufferInfo;
+			VkImageCreateInfo	  ImageInfo;
+			VkImageLayout		  Layout;
+			VkImageAspectFlags	  Aspect;
+			VkMemoryRequirements  Requirements;
+			std::vector<uint32_t> QueueFamilyIndices;	//what the create infos' pQueueFamilyIndices point to
+			MovedCallback		  OnMoved;
+			bool				  Live	   = false;
+			bool				  Moving   = false;
+			bool				  Released = false;
+		};
+		struct Move {
+			uint32_t   Handle;
+			VkBuffer   Buffer;
+			VkImage	   Image;
+			Allocation Memory;
+		};
+		struct Retired {
+			VkBuffer   Buffer;
+			VkImage	   Image;
+			Allocation Memory;
+			uint64_t   Frame;	//the last frame that may use it
+		};
+
+		bool Register(Entry&& entry, uint32_t& handle);
+		void FinishPass();
+		bool BeginPass();
+		bool CreateCopy(const Entry& entry, Move& move);
+		void Retire(VkBuffer buffer, VkImage image, const Allocation& memory);
+		void DestroyRetired(bool all);
+
+		DeviceMemoryAllocator*	Allocator	   = nullptr;
+		VkQueue					Queue		   = VK_NULL_HANDLE;
+		VkCommandPool			CommandPool	   = VK_NULL_HANDLE;
+		VkCommandBuffer			CommandBuffer  = VK_NULL_HANDLE;
+		VkFence					Fence		   = VK_NULL_HANDLE;
+		FrameTimeline*			Timeline	   = nullptr;
+		DefragmentationSettings Settings;
+		bool					PassInFlight   = false;
+		std::vector<Entry>		Resources;
+		std::vector<uint32_t>	UnusedHandles;
+		std::vector<Move>		Moves;
+		std::deque<Retired>		RetiredResources;
+	};
+}
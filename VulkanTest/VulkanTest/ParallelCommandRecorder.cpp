@@ -0,0 +1,116 @@
+#include "ParallelCommandRecorder.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	bool ParallelCommandRecorder::Create(const LogicalDevice& device, FrameCommandPools& pools, JobSystem& jobs, uint32_t minDrawsPerSlice) {
+		if (pools.ThreadCount() < jobs.ThreadCount()) {
+			std::cout << "The frame command pools need a pool for each of the " << jobs.ThreadCount() << " job threads." << std::endl;
+			return false;
+		}
+		if (!Create(device, jobs, minDrawsPerSlice))
+			return false;
+		Pools = &pools;
+		return true;
+	}
+
+	bool ParallelCommandRecorder::Create(const LogicalDevice& device, JobSystem& jobs, uint32_t minDrawsPerSlice) {
+		Device = &device;
+		Pools = nullptr;
+		Jobs = &jobs;
+		MinDrawsPerSlice = std::max(minDrawsPerSlice, 1u);
+		Slices.resize(jobs.ThreadCount());
+		Statistics = {};
+		return true;
+	}
+
+	void ParallelCommandRecorder::Destroy() {
+		Slices.clear();
+		Device = nullptr;
+		Pools = nullptr;
+		Jobs = nullptr;
+	}
+
+	bool ParallelCommandRecorder::Record(VkCommandBuffer primary, VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer,
+		uint32_t drawCount, const SliceRecorder& recordSlice) {
+		if (!Pools) {
+			std::cout << "The recorder was created without frame command pools." << std::endl;
+			return false;
+		}
+		auto acquire = [this](uint32_t threadIndex) { return Pools->Acquire(threadIndex, VK_COMMAND_BUFFER_LEVEL_SECONDARY); };
+		if (!RecordSlices(renderPass, subpass, framebuffer, drawCount, recordSlice, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, acquire, CommandBuffers))
+			return false;
+		if (!CommandBuffers.empty())
+			Device->Dispatch.vkCmdExecuteCommands(primary, static_cast<uint32_t>(CommandBuffers.size()), CommandBuffers.data());
+		return true;
+	}
+
+	bool ParallelCommandRecorder::RecordSlices(VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer, uint32_t drawCount,
+		const SliceRecorder& recordSlice, VkCommandBufferUsageFlags usage, const CommandBufferSource& acquire,
+		std::vector<VkCommandBuffer>& commandBuffers) {
+		commandBuffers.clear();
+		Milliseconds recordTime;
+		uint32_t sliceCount;
+		{
+			ScopedTimer timer(recordTime);
+			sliceCount = std::min(static_cast<uint32_t>(Slices.size()), (drawCount + MinDrawsPerSlice - 1) / MinDrawsPerSlice);
+			if (sliceCount == 0) {
+				Statistics = {};
+				return true;
+			}
+			Inheritance = {
+				VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,	//sType
+				nullptr,											//pNext
+				renderPass,											//renderPass
+				subpass,											//subpass
+				framebuffer,										//framebuffer
+				VK_FALSE,											//occlusionQueryEnable
+				0,													//queryFlags
+				0													//pipelineStatistics
+			};
+			Usage = usage | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			Recorder = &recordSlice;
+			JobCounter recorded;
+			uint32_t first = 0;
+			for (uint32_t index = 0; index < sliceCount; ++index) {
+				Slice& slice = Slices[index];
+				slice.First = first;
+				slice.Count = drawCount / sliceCount + (index < drawCount % sliceCount ? 1 : 0);
+				slice.CommandBuffer = VK_NULL_HANDLE;
+				first += slice.Count;
+				Jobs->Run([this, &slice, &acquire] { RecordSlice(slice, acquire); }, &recorded);
+			}
+			Jobs->Wait(recorded);
+			Recorder = nullptr;
+		}
+		Statistics.Slices = sliceCount;
+		Statistics.RecordTime = recordTime;
+
+		for (uint32_t index = 0; index < sliceCount; ++index) {
+			if (!Slices[index].CommandBuffer) {
+				std::cout << "Could not record a secondary command buffer." << std::endl;
+				commandBuffers.clear();
+				return false;
+			}
+			commandBuffers.push_back(Slices[index].CommandBuffer);
+		}
+		return true;
+	}
+
+	//A thread runs one job at a time, so the pool of the running thread is not used by anyone else.
+	void ParallelCommandRecorder::RecordSlice(Slice& slice, const CommandBufferSource& acquire) {
+		VkCommandBuffer commandBuffer = acquire(JobSystem::ThreadIndex());
+		if (!commandBuffer)
+			return;
+		VkCommandBufferBeginInfo beginInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,	//sType
+			nullptr,										//pNext
+			Usage,											//flags
+			&Inheritance									//pInheritanceInfo
+		};
+		if (Device->Dispatch.vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+			return;
+		(*Recorder)(commandBuffer, slice.First, slice.Count);
+		if (Device->Dispatch.vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			return;
+		slice.CommandBuffer = commandBuffer;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Common.h"
+#include "FrameCommandPools.h"
+#include "JobSystem.h"
+namespace VulkanCookbook {
+	//Records draws [first, first + count) of a draw list into a secondary command buffer that continues
+	//the render pass. Secondary command buffers inherit no state, so it binds everything it uses.
+	//Called on several threads at once.
+	using SliceRecorder = std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count)>;
+	//A secondary command buffer, not in use, that threadIndex may record; VK_NULL_HANDLE on failure.
+	using CommandBufferSource = std::function<VkCommandBuffer(uint32_t threadIndex)>;
+
+	struct ParallelRecordStats {
+		uint32_t	 Slices = 0;	//of the last Record or RecordSlices
+		Milliseconds RecordTime{};	//of the same, from queuing the jobs until the last slice is done
+	};
+
+	//Splits a draw list into one slice per job thread and records the slices into secondary command
+	//buffers as jobs of a JobSystem; the caller helps while it waits. For Record, each slice takes its
+	//command buffer from the pool of the thread that runs it, so the FrameCommandPools need one thread
+	//per job thread; RecordSlices takes them from the caller's source and needs no pools.
+	//A draw is one entry of the caller's list, usually one draw call. Lists shorter than minDrawsPerSlice
+	//per thread use fewer slices, since a job costs more than a few draws; a single draw gets a single slice.
+	class ParallelCommandRecorder {
+	 public:
+		bool Create(const LogicalDevice& device, FrameCommandPools& pools, JobSystem& jobs, uint32_t minDrawsPerSlice = 256);
+		//Without pools, only RecordSlices may be used.
+		bool Create(const LogicalDevice& device, JobSystem& jobs, uint32_t minDrawsPerSlice = 256);
+		void Destroy();
+
+		//primary must have begun the subpass with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, and
+		//the pools' frame must have been begun. Executes the slices in draw list order.
+		bool Record(VkCommandBuffer primary, VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer,
+			uint32_t drawCount, const SliceRecorder& recordSlice);
+		//Records the slices with usage | RENDER_PASS_CONTINUE into command buffers that acquire hands to the
+		//thread recording each slice, and returns them in draw list order without executing them.
+		bool RecordSlices(VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer, uint32_t drawCount,
+			const SliceRecorder& recordSlice, VkCommandBufferUsageFlags usage, const CommandBufferSource& acquire,
+			std::vector<VkCommandBuffer>& commandBuffers);
+
+		const ParallelRecordStats& Stats() const { return Statistics; }
+	 private:
+		struct Slice {
+			uint32_t		First		  = 0;
+			uint32_t		Count		  = 0;
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;	//null if recording failed
+		};
+
+		void RecordSlice(Slice& slice, const CommandBufferSource& acquire);
+
+		const LogicalDevice*			Device			 = nullptr;
+		FrameCommandPools*				Pools			 = nullptr;
+		JobSystem*						Jobs			 = nullptr;
+		uint32_t						MinDrawsPerSlice = 1;
+		std::vector<Slice>				Slices;	//at most one per job thread
+		std::vector<VkCommandBuffer>	CommandBuffers;	//of the last Record
+		VkCommandBufferInheritanceInfo	Inheritance		 = {};
+		VkCommandBufferUsageFlags		Usage			 = 0;
+		const SliceRecorder*			Recorder		 = nullptr;
+		ParallelRecordStats				Statistics;
+	};
+}
@@ -0,0 +1,98 @@
+#include "PhysicalDeviceInfo.h"
+#include <climits>
+namespace VulkanCookbook {
+	PhysicalDeviceInfo::PhysicalDeviceInfo(VkPhysicalDevice							physicalDevice,
+										   const VkPhysicalDeviceFeatures&			features,
+										   const VkPhysicalDeviceProperties&		properties,
+										   std::vector<VkQueueFamilyProperties>		queueFamilies,
+										   const VkPhysicalDeviceMemoryProperties&	memoryProperties,
+										   ExtensionSet								extensions)
+		: PhysicalDevice(physicalDevice),
+		  DeviceFeatures(features),
+		  DeviceProperties(properties),
+		  DeviceQueueFamilies(std::move(queueFamilies)),
+		  DeviceMemoryProperties(memoryProperties),
+		  DeviceExtensions(std::move(extensions)) {
+	}
+
+	const VkFormatProperties& PhysicalDeviceInfo::FormatProperties(VkFormat format) const {
+		auto cached = Formats.find(format);
+		if (cached == Formats.end()) {
+			VkFormatProperties formatProperties = {};
+			if (PhysicalDevice != VK_NULL_HANDLE)
+				vkGetPhysicalDeviceFormatProperties(PhysicalDevice, format, &formatProperties);
+			cached = Formats.emplace(format, formatProperties).first;
+		}
+		return cached->second;
+	}
+
+	void PhysicalDeviceInfo::SetFormatProperties(VkFormat format, const VkFormatProperties& formatProperties) {
+		Formats[format] = formatProperties;
+	}
+
+	bool PhysicalDeviceInfo::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t& memoryTypeIndex) const {
+		for (uint32_t index = 0; index < DeviceMemoryProperties.memoryTypeCount; ++index)
+			if ((typeFilter & (1u << index)) &&
+				(DeviceMemoryProperties.memoryTypes[index].propertyFlags & properties) == properties) {
+				memoryTypeIndex = index;
+				return true;
+			}
+		return false;
+	}
+
+	bool PhysicalDeviceInfo::FindMemoryType(uint32_t typeFilter, const MemoryTypePreference& preference, uint32_t& memoryTypeIndex) const {
+		auto countBits = [](VkMemoryPropertyFlags flags) {
+			uint32_t count = 0;
+			for (; flags; flags &= flags - 1)
+				++count;
+			return static_cast<int>(count);
+		};
+		int bestScore = INT_MIN;
+		for (uint32_t index = 0; index < DeviceMemoryProperties.memoryTypeCount; ++index) {
+			VkMemoryPropertyFlags flags = DeviceMemoryProperties.memoryTypes[index].propertyFlags;
+			if (!(typeFilter & (1u << index)) || (flags & preference.Required) != preference.Required)
+				continue;
+			//a preferred or avoided flag outweighs any number of unrelated ones
+			int score = 64 * (countBits(flags & preference.Preferred) - countBits(flags & preference.Avoided)) -
+						countBits(flags & ~(preference.Required | preference.Preferred));
+			if (score > bestScore) {
+				bestScore = score;
+				memoryTypeIndex = index;
+			}
+		}
+		return bestScore != INT_MIN;
+	}
+
+	bool PhysicalDeviceInfo::FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling,
+												 VkFormatFeatureFlags features, VkFormat& format) const {
+		for (VkFormat candidate : candidates) {
+			const VkFormatProperties& formatProperties = FormatProperties(candidate);
+			VkFormatFeatureFlags supported = tiling == VK_IMAGE_TILING_LINEAR ? formatProperties.linearTilingFeatures
+																			  : formatProperties.optimalTilingFeatures;
+			if ((supported & features) == features) {
+				format = candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	VkSampleCountFlagBits PhysicalDeviceInfo::MaxUsableSampleCount() const {
+		VkSampleCountFlags counts = DeviceProperties.limits.framebufferColorSampleCounts &
+									DeviceProperties.limits.framebufferDepthSampleCounts;
+
+		for (VkSampleCountFlagBits samples : { VK_SAMPLE_COUNT_64_BIT, VK_SAMPLE_COUNT_32_BIT, VK_SAMPLE_COUNT_16_BIT,
+											   VK_SAMPLE_COUNT_8_BIT, VK_SAMPLE_COUNT_4_BIT, VK_SAMPLE_COUNT_2_BIT })
+			if (counts & samples)
+				return samples;
+		return VK_SAMPLE_COUNT_1_BIT;
+	}
+
+	VkDeviceSize PhysicalDeviceInfo::DeviceLocalHeapSize() const {
+		VkDeviceSize size = 0;
+		for (uint32_t index = 0; index < DeviceMemoryProperties.memoryHeapCount; ++index)
+			if (DeviceMemoryProperties.memoryHeaps[index].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+				size += DeviceMemoryProperties.memoryHeaps[index].size;
+		return size;
+	}
+}
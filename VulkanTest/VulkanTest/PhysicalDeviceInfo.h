@@ -0,0 +1,52 @@
+#pragma once
+#include "Common.h"
+namespace VulkanCookbook {
+	//Required flags must all be present; among the types that have them, the one with the most
+	//Preferred and the fewest Avoided flags wins, then the one with the fewest unrelated flags.
+	struct MemoryTypePreference {
+		VkMemoryPropertyFlags Required	= 0;
+		VkMemoryPropertyFlags Preferred = 0;
+		VkMemoryPropertyFlags Avoided	= 0;
+	};
+
+	//Snapshot of everything the renderer asks a physical device about, filled once per device
+	//(see vkapp::getPhysicalDeviceInfo). Format properties are queried lazily, one format at a time.
+	//Not thread-safe: the format table is filled on first use.
+	class PhysicalDeviceInfo {
+	 public:
+		//Builds the snapshot from data that was already queried; a null handle gives a fake
+		//device whose format properties come only from SetFormatProperties.
+		PhysicalDeviceInfo(VkPhysicalDevice							physicalDevice,
+						   const VkPhysicalDeviceFeatures&			features,
+						   const VkPhysicalDeviceProperties&		properties,
+						   std::vector<VkQueueFamilyProperties>		queueFamilies,
+						   const VkPhysicalDeviceMemoryProperties&	memoryProperties,
+						   ExtensionSet								extensions);
+
+		VkPhysicalDevice							Handle() const			 { return PhysicalDevice; }
+		const VkPhysicalDeviceFeatures&				Features() const		 { return DeviceFeatures; }
+		const VkPhysicalDeviceProperties&			Properties() const		 { return DeviceProperties; }
+		const VkPhysicalDeviceLimits&				Limits() const			 { return DeviceProperties.limits; }
+		const std::vector<VkQueueFamilyProperties>& QueueFamilies() const	 { return DeviceQueueFamilies; }
+		const VkPhysicalDeviceMemoryProperties&		MemoryProperties() const { return DeviceMemoryProperties; }
+		const ExtensionSet&							Extensions() const		 { return DeviceExtensions; }
+
+		const VkFormatProperties& FormatProperties(VkFormat format) const;
+		void SetFormatProperties(VkFormat format, const VkFormatProperties& formatProperties);
+
+		bool FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t& memoryTypeIndex) const;
+		bool FindMemoryType(uint32_t typeFilter, const MemoryTypePreference& preference, uint32_t& memoryTypeIndex) const;
+		bool FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling,
+								 VkFormatFeatureFlags features, VkFormat& format) const;
+		VkSampleCountFlagBits MaxUsableSampleCount() const;
+		VkDeviceSize DeviceLocalHeapSize() const;
+	 private:
+		VkPhysicalDevice									  PhysicalDevice;
+		VkPhysicalDeviceFeatures							  DeviceFeatures;
+		VkPhysicalDeviceProperties							  DeviceProperties;
+		std::vector<VkQueueFamilyProperties>				  DeviceQueueFamilies;
+		VkPhysicalDeviceMemoryProperties					  DeviceMemoryProperties;
+		ExtensionSet										  DeviceExtensions;
+		mutable std::unordered_map<VkFormat, VkFormatProperties> Formats;
+	};
+}
@@ -0,0 +1,108 @@
+#include "QueuePlanner.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	namespace {
+		constexpr VkQueueFlags CapabilityFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+
+		//Graphics and compute families support transfers whether or not they report the bit.
+		VkQueueFlags Capabilities(const VkQueueFamilyProperties& family) {
+			VkQueueFlags flags = family.queueFlags & CapabilityFlags;
+			if (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))
+				flags |= VK_QUEUE_TRANSFER_BIT;
+			return flags;
+		}
+
+		uint32_t CountBits(VkQueueFlags flags) {
+			uint32_t count = 0;
+			for (; flags; flags &= flags - 1)
+				++count;
+			return count;
+		}
+
+		//The family with every required capability and the fewest others; more queues break ties.
+		uint32_t MostSpecialisedFamily(const std::vector<VkQueueFamilyProperties>& families, VkQueueFlags required,
+									   const std::vector<VkBool32>* presentSupport = nullptr) {
+			uint32_t best = UINT32_MAX, bestExtra = UINT32_MAX;
+			for (uint32_t index = 0; index < static_cast<uint32_t>(families.size()); ++index) {
+				VkQueueFlags capabilities = Capabilities(families[index]);
+				if (families[index].queueCount == 0 || (capabilities & required) != required)
+					continue;
+				if (presentSupport && (index >= presentSupport->size() || !(*presentSupport)[index]))
+					continue;
+				uint32_t extra = CountBits(capabilities & ~required);
+				if (extra < bestExtra || (extra == bestExtra && families[index].queueCount > families[best].queueCount)) {
+					best = index;
+					bestExtra = extra;
+				}
+			}
+			return best;
+		}
+	}
+
+	bool PlanQueues(const PhysicalDeviceInfo& device, const std::vector<VkBool32>& presentSupport, uint32_t workloads,
+					const QueuePriorities& priorities, QueuePlan& plan) {
+		plan = {};
+		auto& families = device.QueueFamilies();
+		std::vector<std::vector<float>> familyPriorities(families.size());
+
+		auto assign = [&](QueueWorkload workload, uint32_t familyIndex, float priority) {
+			std::vector<float>& queues = familyPriorities[familyIndex];
+			uint32_t queueIndex;
+			if (queues.size() < families[familyIndex].queueCount) {
+				queueIndex = static_cast<uint32_t>(queues.size());
+				queues.push_back(priority);
+			}
+			else {
+				//family is out of queues, share the last one and keep the higher priority
+				queueIndex = static_cast<uint32_t>(queues.size() - 1);
+				queues.back() = std::max(queues.back(), priority);
+			}
+			plan.Assignments[QueuePlan::Index(workload)] = { familyIndex, queueIndex, false };
+		};
+		auto share = [&](QueueWorkload workload, QueueWorkload with) {
+			plan.Assignments[QueuePlan::Index(workload)] = plan.Assignments[QueuePlan::Index(with)];
+		};
+
+		uint32_t graphicsFamily = MostSpecialisedFamily(families, VK_QUEUE_GRAPHICS_BIT);
+		if (graphicsFamily == UINT32_MAX) {
+			std::cout << "Could not find a queue family with graphics support." << std::endl;
+			return false;
+		}
+		assign(QueueWorkload::Graphics, graphicsFamily, priorities.Graphics);
+
+		if (workloads & WorkloadBit(QueueWorkload::Present)) {
+			//presenting from the graphics queue avoids an ownership transfer of every swapchain image
+			if (graphicsFamily < presentSupport.size() && presentSupport[graphicsFamily])
+				share(QueueWorkload::Present, QueueWorkload::Graphics);
+			else if (uint32_t presentFamily = MostSpecialisedFamily(families, 0, &presentSupport); presentFamily != UINT32_MAX)
+				assign(QueueWorkload::Present, presentFamily, priorities.Graphics);
+			else {
+				std::cout << "Could not find a queue family that supports presentation." << std::endl;
+				return false;
+			}
+		}
+
+		if (workloads & WorkloadBit(QueueWorkload::AsyncCompute)) {
+			uint32_t computeFamily = MostSpecialisedFamily(families, VK_QUEUE_COMPUTE_BIT);
+			if (computeFamily == UINT32_MAX)
+				share(QueueWorkload::AsyncCompute, QueueWorkload::Graphics);
+			else
+				assign(QueueWorkload::AsyncCompute, computeFamily, priorities.AsyncCompute);
+		}
+
+		if (workloads & WorkloadBit(QueueWorkload::Transfer))
+			assign(QueueWorkload::Transfer, MostSpecialisedFamily(families, VK_QUEUE_TRANSFER_BIT), priorities.Transfer);
+
+		for (auto& assignment : plan.Assignments) {
+			if (assignment.FamilyIndex == UINT32_MAX)
+				continue;
+			assignment.Dedicated = std::count_if(plan.Assignments.begin(), plan.Assignments.end(), [&](const QueueAssignment& other) {
+				return other.FamilyIndex == assignment.FamilyIndex && other.QueueIndex == assignment.QueueIndex;
+			}) == 1;
+		}
+		for (uint32_t index = 0; index < static_cast<uint32_t>(familyPriorities.size()); ++index)
+			if (!familyPriorities[index].empty())
+				plan.Requests.push_back({ index, std::move(familyPriorities[index]) });
+		return true;
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "PhysicalDeviceInfo.h"
+namespace VulkanCookbook {
+	enum class QueueWorkload : uint32_t {
+		Graphics,
+		Present,
+		AsyncCompute,
+		Transfer,
+		Count
+	};
+	constexpr size_t QueueWorkloadCount = static_cast<size_t>(QueueWorkload::Count);
+
+	struct QueueAssignment {
+		uint32_t FamilyIndex = UINT32_MAX;
+		uint32_t QueueIndex	 = 0;
+		bool	 Dedicated	 = false;	//no other workload runs on this queue
+	};
+
+	struct QueueFamilyRequest {
+		uint32_t		   FamilyIndex;
+		std::vector<float> Priorities;
+	};
+
+	struct QueuePriorities {
+		float Graphics	   = 1.0f;
+		float AsyncCompute = 0.5f;
+		float Transfer	   = 0.25f;
+	};
+
+	//Which family and queue each workload runs on, plus the VkDeviceQueueCreateInfo contents that back it.
+	class QueuePlan {
+	 public:
+		bool Has(QueueWorkload workload) const { return Assignments[Index(workload)].FamilyIndex != UINT32_MAX; }
+		const QueueAssignment& Assignment(QueueWorkload workload) const { return Assignments[Index(workload)]; }
+		const std::vector<QueueFamilyRequest>& FamilyRequests() const { return Requests; }
+	 private:
+		friend bool PlanQueues(const PhysicalDeviceInfo&, const std::vector<VkBool32>&, uint32_t, const QueuePriorities&, QueuePlan&);
+		static size_t Index(QueueWorkload workload) { return static_cast<size_t>(workload); }
+
+		std::array<QueueAssignment, QueueWorkloadCount> Assignments;
+		std::vector<QueueFamilyRequest>					Requests;
+	};
+
+	struct QueueMap {
+		std::array<VkQueue, QueueWorkloadCount>	 Queues = {};
+		std::array<uint32_t, QueueWorkloadCount> FamilyIndices = {};
+
+		VkQueue	 Get(QueueWorkload workload) const		  { return Queues[static_cast<size_t>(workload)]; }
+		uint32_t FamilyIndex(QueueWorkload workload) const { return FamilyIndices[static_cast<size_t>(workload)]; }
+	};
+
+	constexpr uint32_t WorkloadBit(QueueWorkload workload) { return 1u << static_cast<uint32_t>(workload); }
+
+	//Picks the most specialised family for each requested workload (a bitmask of WorkloadBit values):
+	//a compute-only family for async compute, a transfer-only family for streaming, and the graphics
+	//family for present when it can. Workloads sharing a family get separate queues while the family
+	//has them. presentSupport holds one entry per family and may be empty when Present is not requested.
+	//Graphics is required; the other workloads fall back to the graphics queue when nothing better exists.
+	bool PlanQueues(const PhysicalDeviceInfo& device, const std::vector<VkBool32>& presentSupport, uint32_t workloads,
+					const QueuePriorities& priorities, QueuePlan& plan);
+}
@@ -0,0 +1,547 @@
+#include "RenderGraph.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	namespace {
+		bool HasStencil(VkFormat format) {
+			return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+				   format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_S8_UINT;
+		}
+		VkImageAspectFlags AspectOf(VkFormat format) {
+			switch (format) {
+			case VK_FORMAT_D16_UNORM:
+			case VK_FORMAT_X8_D24_UNORM_PACK32:
+			case VK_FORMAT_D32_SFLOAT:			return VK_IMAGE_ASPECT_DEPTH_BIT;
+			case VK_FORMAT_S8_UINT:				return VK_IMAGE_ASPECT_STENCIL_BIT;
+			case VK_FORMAT_D16_UNORM_S8_UINT:
+			case VK_FORMAT_D24_UNORM_S8_UINT:
+			case VK_FORMAT_D32_SFLOAT_S8_UINT:	return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+			default:							return VK_IMAGE_ASPECT_COLOR_BIT;
+			}
+		}
+	}
+
+	void RenderGraph::Create(const LogicalDevice& device, TransientImagePool& transientImages, ResourceStateTracker& states) {
+		Device = &device;
+		TransientImages = &transientImages;
+		States = &states;
+	}
+
+	void RenderGraph::Destroy() {
+		if (!Device)
+			return;
+		Reset();
+		Device = nullptr;
+	}
+
+	GraphResource RenderGraph::CreateImage(const char* name, const GraphImageDesc& desc) {
+		ResourceNode resource;
+		resource.Name = name;
+		resource.Desc = desc;
+		Resources.push_back(resource);
+		return static_cast<GraphResource>(Resources.size() - 1);
+	}
+
+	GraphResource RenderGraph::ImportImage(const char* name, const std::vector<VkImage>& images, const std::vector<VkImageView>& views,
+		const GraphImageDesc& desc, const ResourceUsage& initial, const ResourceUsage& final) {
+		ResourceNode resource;
+		resource.Name = name;
+		resource.Desc = desc;
+		resource.Imported = true;
+		resource.Images = images;
+		resource.Views = views;
+		resource.Initial = initial;
+		resource.Final = final;
+		Resources.push_back(resource);
+		return static_cast<GraphResource>(Resources.size() - 1);
+	}
+
+	void RenderGraph::ResizeImage(GraphResource image, VkExtent2D extent) {
+		Resources[image].Desc.Extent = extent;
+	}
+
+	void RenderGraph::ReimportImage(GraphResource image, const std::vector<VkImage>& images, const std::vector<VkImageView>& views,
+		VkExtent2D extent) {
+		ResourceNode& resource = Resources[image];
+		for (auto oldImage : resource.Images)
+			States->ForgetImage(oldImage);
+		resource.Images = images;
+		resource.Views = views;
+		resource.Desc.Extent = extent;
+	}
+
+	GraphPass RenderGraph::AddPass(const char* name, PassType type, PassRecorder recorder, VkSubpassContents contents) {
+		PassNode pass;
+		pass.Name = name;
+		pass.Type = type;
+		pass.Recorder = std::move(recorder);
+		pass.Contents = contents;
+		Passes.push_back(std::move(pass));
+		return static_cast<GraphPass>(Passes.size() - 1);
+	}
+
+	void RenderGraph::AddAccess(GraphPass pass, const Access& access) {
+		Passes[pass].Accesses.push_back(access);
+	}
+
+	void RenderGraph::ColorAttachment(GraphPass pass, GraphResource image, const std::optional<VkClearColorValue>& clear) {
+		std::optional<VkClearValue> clearValue;
+		if (clear) {
+			clearValue = VkClearValue();
+			clearValue->color = *clear;
+		}
+		AddAccess(pass, { image, AccessKind::Color, Usage::ColorAttachmentWrite, !clear, true, clearValue });
+	}
+
+	void RenderGraph::DepthAttachment(GraphPass pass, GraphResource image, const std::optional<VkClearDepthStencilValue>& clear) {
+		std::optional<VkClearValue> clearValue;
+		if (clear) {
+			clearValue = VkClearValue();
+			clearValue->depthStencil = *clear;
+		}
+		AddAccess(pass, { image, AccessKind::Depth, Usage::DepthStencilAttachment, !clear, true, clearValue });
+	}
+
+	void RenderGraph::ResolveAttachment(GraphPass pass, GraphResource image) {
+		AddAccess(pass, { image, AccessKind::Resolve, Usage::ColorAttachmentWrite, false, true, std::nullopt });
+	}
+
+	void RenderGraph::SampledImage(GraphPass pass, GraphResource image, VkPipelineStageFlags stages) {
+		ResourceUsage usage = { stages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		AddAccess(pass, { image, AccessKind::Sampled, usage, true, false, std::nullopt });
+	}
+
+	void RenderGraph::StorageImage(GraphPass pass, GraphResource image, VkPipelineStageFlags stages, bool write) {
+		ResourceUsage usage = { stages, static_cast<VkAccessFlags>(VK_ACCESS_SHADER_READ_BIT | (write ? VK_ACCESS_SHADER_WRITE_BIT : 0)), VK_IMAGE_LAYOUT_GENERAL };
+		AddAccess(pass, { image, AccessKind::Storage, usage, true, write, std::nullopt });
+	}
+
+	void RenderGraph::MarkOutput(GraphResource image) {
+		Resources[image].Output = true;
+	}
+
+	bool RenderGraph::Compile() {
+		if (Compiled) {
+			std::cout << "The render graph is already compiled; call Reset first." << std::endl;
+			return false;
+		}
+		if (!SortPasses())
+			return false;
+		CullPasses();
+		if (!CreateImages())
+			return false;
+		for (uint32_t position = 0; position < Order.size(); ++position) {
+			PassNode& pass = Passes[Order[position]];
+			if (pass.Type == PassType::Graphics && (!CreateRenderPass(pass, position) || !CreateFramebuffers(pass)))
+				return false;
+		}
+		Compiled = true;
+		return true;
+	}
+
+	bool RenderGraph::Resize() {
+		if (!Compiled) {
+			std::cout << "The render graph has to be compiled before it is resized." << std::endl;
+			return false;
+		}
+		DestroyImages();
+		if (!CreateImages())
+			return false;
+		for (GraphPass index : Order)
+			if (Passes[index].Type == PassType::Graphics && !CreateFramebuffers(Passes[index]))
+				return false;
+		return true;
+	}
+
+	//Every writer of an image runs before its readers, and the writers of one image keep the order they
+	//were added in. Among the passes that are ready, the one added first goes first.
+	bool RenderGraph::SortPasses() {
+		size_t passCount = Passes.size();
+		std::vector<std::vector<GraphPass>> successors(passCount);
+		std::vector<uint32_t> predecessorCount(passCount, 0);
+		for (GraphResource resource = 0; resource < Resources.size(); ++resource) {
+			std::vector<GraphPass> writers;
+			std::vector<GraphPass> readers;
+			for (GraphPass pass = 0; pass < passCount; ++pass) {
+				bool accessed = false;
+				bool writes = false;
+				for (auto& access : Passes[pass].Accesses)
+					if (access.Resource == resource) {
+						accessed = true;
+						writes = writes || access.Writes;
+					}
+				if (accessed)
+					(writes ? writers : readers).push_back(pass);
+			}
+			auto addEdge = [&](GraphPass from, GraphPass to) {
+				successors[from].push_back(to);
+				++predecessorCount[to];
+			};
+			for (size_t index = 1; index < writers.size(); ++index)
+				addEdge(writers[index - 1], writers[index]);
+			if (!writers.empty())
+				for (GraphPass reader : readers)
+					addEdge(writers.back(), reader);
+		}
+
+		Order.clear();
+		std::vector<bool> sorted(passCount, false);
+		for (size_t step = 0; step < passCount; ++step) {
+			GraphPass next = 0;
+			while (next < passCount && (sorted[next] || predecessorCount[next] > 0))
+				++next;
+			if (next == passCount) {
+				std::cout << "The passes of the render graph depend on each other in a cycle." << std::endl;
+				return false;
+			}
+			sorted[next] = true;
+			Order.push_back(next);
+			for (GraphPass successor : successors[next])
+				--predecessorCount[successor];
+		}
+		return true;
+	}
+
+	//Walks the order backwards from the outputs. A pass is kept if it writes an image that is still
+	//needed; an image it overwrites without reading is not needed by the passes before it.
+	void RenderGraph::CullPasses() {
+		std::vector<bool> needed(Resources.size());
+		for (GraphResource resource = 0; resource < Resources.size(); ++resource)
+			needed[resource] = Resources[resource].Output;
+
+		std::vector<GraphPass> kept;
+		for (auto pass = Order.rbegin(); pass != Order.rend(); ++pass) {
+			PassNode& node = Passes[*pass];
+			node.Culled = std::none_of(node.Accesses.begin(), node.Accesses.end(), [&](const Access& access) {
+				return access.Writes && needed[access.Resource];
+			});
+			if (node.Culled)
+				continue;
+			for (auto& access : node.Accesses)
+				if (access.Writes && !access.Reads)
+					needed[access.Resource] = false;
+			for (auto& access : node.Accesses)
+				if (access.Reads)
+					needed[access.Resource] = true;
+			kept.push_back(*pass);
+		}
+		Order.assign(kept.rbegin(), kept.rend());
+		Statistics.Passes = static_cast<uint32_t>(Order.size());
+		Statistics.CulledPasses = static_cast<uint32_t>(Passes.size() - Order.size());
+	}
+
+	bool RenderGraph::CreateImages() {
+		AliasedUsage = {};
+		for (uint32_t position = 0; position < Order.size(); ++position)
+			for (auto& access : Passes[Order[position]].Accesses) {
+				ResourceNode& resource = Resources[access.Resource];
+				resource.FirstPass = std::min(resource.FirstPass, position);
+				resource.LastPass = std::max(resource.LastPass, position);
+				switch (access.Kind) {
+				case AccessKind::Color:
+				case AccessKind::Resolve: resource.Usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; break;
+				case AccessKind::Depth:	  resource.Usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT; break;
+				case AccessKind::Sampled: resource.Usage |= VK_IMAGE_USAGE_SAMPLED_BIT; break;
+				case AccessKind::Storage: resource.Usage |= VK_IMAGE_USAGE_STORAGE_BIT; break;
+				}
+				if (!resource.Imported) {
+					AliasedUsage.Stages |= access.Usage.Stages;
+					AliasedUsage.Access |= access.Usage.Access & (VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+																   VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+				}
+			}
+
+		std::vector<ResourceNode*> created;
+		for (auto& resource : Resources) {
+			if (resource.Imported || resource.FirstPass == UINT32_MAX)
+				continue;
+			//an attachment of a single pass is never loaded or stored, so it can live in lazily allocated memory
+			VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			if (resource.FirstPass == resource.LastPass && !(resource.Usage & ~attachmentUsage))
+				resource.Usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+			VkImageCreateInfo imageInfo = {
+				VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,							//sType
+				nullptr,														//pNext
+				0,																//flags
+				VK_IMAGE_TYPE_2D,												//imageType
+				resource.Desc.Format,											//format
+				{ resource.Desc.Extent.width, resource.Desc.Extent.height, 1 },	//extent
+				1,																//mipLevels
+				1,																//arrayLayers
+				resource.Desc.Samples,											//samples
+				VK_IMAGE_TILING_OPTIMAL,										//tiling
+				resource.Usage,													//usage
+				VK_SHARING_MODE_EXCLUSIVE,										//sharingMode
+				0,																//queueFamilyIndexCount
+				nullptr,														//pQueueFamilyIndices
+				VK_IMAGE_LAYOUT_UNDEFINED										//initialLayout
+			};
+			VkImage image;
+			if (!TransientImages->CreateImage(imageInfo, resource.FirstPass, resource.LastPass, image)) {
+				std::cout << "Could not create render graph image " << resource.Name << "." << std::endl;
+				return false;
+			}
+			resource.Images = { image };
+			created.push_back(&resource);
+		}
+		if (!TransientImages->Bind())
+			return false;
+
+		for (ResourceNode* resource : created) {
+			VkImageViewCreateInfo viewInfo = {
+				VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,		//sType
+				nullptr,										//pNext
+				0,												//flags
+				resource->Images[0],							//image
+				VK_IMAGE_VIEW_TYPE_2D,							//viewType
+				resource->Desc.Format,							//format
+				{},												//components
+				{ AspectOf(resource->Desc.Format), 0, 1, 0, 1 }	//subresourceRange
+			};
+			VkImageView view;
+			if (Device->Dispatch.vkCreateImageView(Device->Handle, &viewInfo, Device->HostCallbacks, &view) != VK_SUCCESS) {
+				std::cout << "Could not create a view of render graph image " << resource->Name << "." << std::endl;
+				return false;
+			}
+			resource->Views = { view };
+		}
+		Statistics.TransientImages = static_cast<uint32_t>(created.size());
+		return true;
+	}
+
+	bool RenderGraph::IsWrittenBefore(GraphResource resource, uint32_t position) const {
+		for (uint32_t earlier = 0; earlier < position; ++earlier)
+			for (auto& access : Passes[Order[earlier]].Accesses)
+				if (access.Resource == resource && access.Writes)
+					return true;
+		return false;
+	}
+
+	bool RenderGraph::IsAccessedAfter(GraphResource resource, uint32_t position) const {
+		for (uint32_t later = position + 1; later < Order.size(); ++later)
+			for (auto& access : Passes[Order[later]].Accesses)
+				if (access.Resource == resource)
+					return true;
+		return false;
+	}
+
+	//One subpass. Attachments stay in the layout of the subpass from start to end; the tracker's barriers
+	//in front of the render pass do every transition, so no subpass dependencies are needed.
+	bool RenderGraph::CreateRenderPass(PassNode& pass, uint32_t position) {
+		std::vector<VkAttachmentDescription> attachments;
+		std::vector<VkAttachmentReference> colorReferences;
+		std::vector<VkAttachmentReference> resolveReferences;
+		VkAttachmentReference depthReference = { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+		bool resolves = false;
+		for (auto& access : pass.Accesses) {
+			if (access.Kind != AccessKind::Color && access.Kind != AccessKind::Depth && access.Kind != AccessKind::Resolve)
+				continue;
+			const ResourceNode& resource = Resources[access.Resource];
+			//what was there before only matters if the pass neither clears nor fully overwrites it
+			bool hasContents = IsWrittenBefore(access.Resource, position) || (resource.Imported && resource.Initial.Layout != VK_IMAGE_LAYOUT_UNDEFINED);
+			bool keep = resource.Imported || resource.Output || IsAccessedAfter(access.Resource, position);
+			VkAttachmentLoadOp loadOp = access.Clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+										: access.Reads && hasContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			VkAttachmentStoreOp storeOp = keep ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			bool stencil = HasStencil(resource.Desc.Format);
+			VkImageLayout layout = access.Usage.Layout;
+			attachments.push_back({
+				0,														//flags
+				resource.Desc.Format,									//format
+				resource.Desc.Samples,									//samples
+				loadOp,													//loadOp
+				storeOp,												//storeOp
+				stencil ? loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE,		//stencilLoadOp
+				stencil ? storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE,	//stencilStoreOp
+				layout,													//initialLayout
+				layout													//finalLayout
+			});
+			VkAttachmentReference reference = { static_cast<uint32_t>(attachments.size() - 1), layout };
+			if (access.Kind == AccessKind::Color) {
+				colorReferences.push_back(reference);
+				resolveReferences.push_back({ VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED });
+			} else if (access.Kind == AccessKind::Depth)
+				depthReference = reference;
+			else if (colorReferences.empty()) {
+				std::cout << "Pass " << pass.Name << " resolves before it has a color attachment." << std::endl;
+				return false;
+			} else {
+				resolveReferences.back() = reference;
+				resolves = true;
+			}
+			pass.ClearValues.push_back(access.Clear.value_or(VkClearValue()));
+		}
+
+		VkSubpassDescription subpass = {
+			0,																				//flags
+			VK_PIPELINE_BIND_POINT_GRAPHICS,												//pipelineBindPoint
+			0,																				//inputAttachmentCount
+			nullptr,																		//pInputAttachments
+			static_cast<uint32_t>(colorReferences.size()),									//colorAttachmentCount
+			colorReferences.data(),															//pColorAttachments
+			resolves ? resolveReferences.data() : nullptr,									//pResolveAttachments
+			depthReference.attachment != VK_ATTACHMENT_UNUSED ? &depthReference : nullptr,	//pDepthStencilAttachment
+			0,																				//preserveAttachmentCount
+			nullptr																			//pPreserveAttachments
+		};
+		VkRenderPassCreateInfo renderPassInfo = {
+			VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,	//sType
+			nullptr,									//pNext
+			0,											//flags
+			static_cast<uint32_t>(attachments.size()),	//attachmentCount
+			attachments.data(),							//pAttachments
+			1,											//subpassCount
+			&subpass,									//pSubpasses
+			0,											//dependencyCount
+			nullptr										//pDependencies
+		};
+		if (Device->Dispatch.vkCreateRenderPass(Device->Handle, &renderPassInfo, Device->HostCallbacks, &pass.RenderPass) != VK_SUCCESS) {
+			std::cout << "Could not create the render pass of pass " << pass.Name << "." << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	//The render pass only depends on formats and samples, so the framebuffers are all that follows the
+	//size of the attachments and the imported images.
+	bool RenderGraph::CreateFramebuffers(PassNode& pass) {
+		bool first = true;
+		size_t variants = 1;
+		for (auto& access : pass.Accesses) {
+			if (access.Kind != AccessKind::Color && access.Kind != AccessKind::Depth && access.Kind != AccessKind::Resolve)
+				continue;
+			const ResourceNode& resource = Resources[access.Resource];
+			if (first)
+				pass.Extent = resource.Desc.Extent;
+			else if (pass.Extent.width != resource.Desc.Extent.width || pass.Extent.height != resource.Desc.Extent.height) {
+				std::cout << "The attachments of pass " << pass.Name << " differ in size." << std::endl;
+				return false;
+			}
+			first = false;
+			if (resource.Imported)
+				variants = std::max(variants, resource.Views.size());
+		}
+
+		pass.Framebuffers.assign(variants, VK_NULL_HANDLE);
+		for (size_t variant = 0; variant < variants; ++variant) {
+			std::vector<VkImageView> views;
+			for (auto& access : pass.Accesses)
+				if (access.Kind == AccessKind::Color || access.Kind == AccessKind::Depth || access.Kind == AccessKind::Resolve) {
+					const ResourceNode& resource = Resources[access.Resource];
+					views.push_back(resource.Views[std::min(variant, resource.Views.size() - 1)]);
+				}
+			VkFramebufferCreateInfo framebufferInfo = {
+				VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,	//sType
+				nullptr,									//pNext
+				0,											//flags
+				pass.RenderPass,							//renderPass
+				static_cast<uint32_t>(views.size()),		//attachmentCount
+				views.data(),								//pAttachments
+				pass.Extent.width,							//width
+				pass.Extent.height,							//height
+				1											//layers
+			};
+			if (Device->Dispatch.vkCreateFramebuffer(Device->Handle, &framebufferInfo, Device->HostCallbacks, &pass.Framebuffers[variant]) != VK_SUCCESS) {
+				std::cout << "Could not create a framebuffer of pass " << pass.Name << "." << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	VkImage RenderGraph::ImageOf(const ResourceNode& resource, uint32_t variant) const {
+		return resource.Images[std::min<size_t>(variant, resource.Images.size() - 1)];
+	}
+
+	bool RenderGraph::Execute(VkCommandBuffer commandBuffer, uint32_t variant) {
+		if (!Compiled) {
+			std::cout << "The render graph has to be compiled before it is executed." << std::endl;
+			return false;
+		}
+		//a transient image starts undefined and may share memory with any other one, so its first
+		//barrier waits for everything the transient images of the graph do
+		for (auto& resource : Resources)
+			if (resource.FirstPass != UINT32_MAX)
+				States->RegisterImage(ImageOf(resource, variant), 1, 1, resource.Imported ? resource.Initial : AliasedUsage);
+
+		auto& dispatch = Device->Dispatch;
+		for (GraphPass index : Order) {
+			PassNode& pass = Passes[index];
+			for (auto& access : pass.Accesses) {
+				const ResourceNode& resource = Resources[access.Resource];
+				if (!States->UseImage(commandBuffer, ImageOf(resource, variant), { AspectOf(resource.Desc.Format), 0, 1, 0, 1 }, access.Usage))
+					return false;
+			}
+			States->Flush(commandBuffer);
+
+			PassContext context;
+			context.CommandBuffer = commandBuffer;
+			context.Variant = variant;
+			bool recorded;
+			if (pass.Type == PassType::Graphics) {
+				context.RenderPass = pass.RenderPass;
+				context.Framebuffer = pass.Framebuffers[std::min<size_t>(variant, pass.Framebuffers.size() - 1)];
+				context.Extent = pass.Extent;
+				VkRenderPassBeginInfo beginInfo = {
+					VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,		//sType
+					nullptr,										//pNext
+					context.RenderPass,								//renderPass
+					context.Framebuffer,							//framebuffer
+					{ { 0, 0 }, pass.Extent },						//renderArea
+					static_cast<uint32_t>(pass.ClearValues.size()),	//clearValueCount
+					pass.ClearValues.data()							//pClearValues
+				};
+				dispatch.vkCmdBeginRenderPass(commandBuffer, &beginInfo, pass.Contents);
+				recorded = pass.Recorder(context);
+				dispatch.vkCmdEndRenderPass(commandBuffer);
+			} else
+				recorded = pass.Recorder(context);
+			if (!recorded) {
+				std::cout << "Could not record pass " << pass.Name << "." << std::endl;
+				return false;
+			}
+		}
+
+		for (auto& resource : Resources)
+			if (resource.Imported && resource.FirstPass != UINT32_MAX && (resource.Final.Stages || resource.Final.Layout != VK_IMAGE_LAYOUT_UNDEFINED))
+				if (!States->UseImage(commandBuffer, ImageOf(resource, variant), { AspectOf(resource.Desc.Format), 0, 1, 0, 1 }, resource.Final))
+					return false;
+		States->Flush(commandBuffer);
+		return true;
+	}
+
+	void RenderGraph::Reset() {
+		if (!Device)
+			return;
+		DestroyImages();
+		for (auto& pass : Passes)
+			Device->Dispatch.vkDestroyRenderPass(Device->Handle, pass.RenderPass, Device->HostCallbacks);
+		for (auto& resource : Resources)
+			for (auto image : resource.Images)
+				States->ForgetImage(image);
+		Resources.clear();
+		Passes.clear();
+		Order.clear();
+		Compiled = false;
+		Statistics = {};
+	}
+
+	void RenderGraph::DestroyImages() {
+		for (auto& pass : Passes) {
+			for (auto framebuffer : pass.Framebuffers)
+				Device->Dispatch.vkDestroyFramebuffer(Device->Handle, framebuffer, Device->HostCallbacks);
+			pass.Framebuffers.clear();
+		}
+		for (auto& resource : Resources) {
+			if (resource.Imported)
+				continue;
+			for (auto image : resource.Images)
+				States->ForgetImage(image);
+			for (auto view : resource.Views)
+				Device->Dispatch.vkDestroyImageView(Device->Handle, view, Device->HostCallbacks);
+			resource.Images.clear();
+			resource.Views.clear();
+		}
+		//the pool holds only the graph's images
+		TransientImages->Reset();
+	}
+}
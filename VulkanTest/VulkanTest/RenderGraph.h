@@ -0,0 +1,137 @@
+#pragma once
+#include "TransientImagePool.h"
+#include "ResourceStateTracker.h"
+namespace VulkanCookbook {
+	struct GraphImageDesc {
+		VkFormat			  Format  = VK_FORMAT_UNDEFINED;
+		VkExtent2D			  Extent  = {};
+		VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
+	};
+
+	enum class PassType { Graphics, Compute };
+
+	//What a pass records into. Graphics passes are recorded inside their render pass; RenderPass and
+	//Framebuffer are what secondary command buffers inherit. Variant is the one given to Execute.
+	struct PassContext {
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		VkRenderPass	RenderPass	  = VK_NULL_HANDLE;	//null for compute passes
+		VkFramebuffer	Framebuffer	  = VK_NULL_HANDLE;
+		VkExtent2D		Extent		  = {};
+		uint32_t		Variant		  = 0;
+	};
+	using PassRecorder = std::function<bool(const PassContext& context)>;
+
+	using GraphResource = uint32_t;
+	using GraphPass = uint32_t;
+
+	struct RenderGraphStats {
+		uint32_t Passes			 = 0;	//executed
+		uint32_t CulledPasses	 = 0;
+		uint32_t TransientImages = 0;
+	};
+
+	//A frame described as passes that declare the images they read and write. Compile culls the passes
+	//whose results reach no output, orders the rest so that every image is written before it is read,
+	//chooses load and store ops from what comes before and after each pass, and creates a render pass
+	//and framebuffers per graphics pass. Images created by the graph are transient: they come from a
+	//TransientImagePool, where images whose pass ranges do not overlap share memory. Execute has the
+	//ResourceStateTracker insert the barriers in front of every pass, so passes contain no
+	//synchronisation of their own.
+	//The declaration is kept until Reset; compile once, execute every frame, and Resize when only the
+	//sizes of the images change.
+	class RenderGraph {
+	 public:
+		void Create(const LogicalDevice& device, TransientImagePool& transientImages, ResourceStateTracker& states);
+		void Destroy();
+
+		GraphResource CreateImage(const char* name, const GraphImageDesc& desc);
+		//Execute with variant i uses images[i] and views[i], e.g. one per swapchain image; a single image is
+		//used for every variant. The images are in initial whenever Execute starts and are left in final.
+		GraphResource ImportImage(const char* name, const std::vector<VkImage>& images, const std::vector<VkImageView>& views,
+			const GraphImageDesc& desc, const ResourceUsage& initial, const ResourceUsage& final);
+		//Change the size of an image, and for an imported one its images and views, e.g. after the window
+		//was resized; Resize applies the change to a compiled graph.
+		void ResizeImage(GraphResource image, VkExtent2D extent);
+		void ReimportImage(GraphResource image, const std::vector<VkImage>& images, const std::vector<VkImageView>& views, VkExtent2D extent);
+		//contents is the one passed to vkCmdBeginRenderPass for graphics passes.
+		GraphPass AddPass(const char* name, PassType type, PassRecorder recorder, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+		//Without a clear value an attachment keeps what earlier passes wrote.
+		void ColorAttachment(GraphPass pass, GraphResource image, const std::optional<VkClearColorValue>& clear = std::nullopt);
+		void DepthAttachment(GraphPass pass, GraphResource image, const std::optional<VkClearDepthStencilValue>& clear = std::nullopt);
+		//Resolves the color attachment declared last.
+		void ResolveAttachment(GraphPass pass, GraphResource image);
+		void SampledImage(GraphPass pass, GraphResource image, VkPipelineStageFlags stages);
+		void StorageImage(GraphPass pass, GraphResource image, VkPipelineStageFlags stages, bool write);
+		//Only passes that lead to an output are executed.
+		void MarkOutput(GraphResource image);
+
+		bool Compile();
+		//Recreates the graph's images and the framebuffers. The render passes, and with them the pipelines
+		//created for them, stay valid as long as formats and sample counts are unchanged. The GPU must be
+		//done with the old images and framebuffers.
+		bool Resize();
+		bool Execute(VkCommandBuffer commandBuffer, uint32_t variant = 0);
+		//Destroys what Compile created and drops the declaration.
+		void Reset();
+
+		VkRenderPass RenderPass(GraphPass pass) const { return Passes[pass].RenderPass; }
+		const RenderGraphStats& Stats() const { return Statistics; }
+	 private:
+		enum class AccessKind { Color, Depth, Resolve, Sampled, Storage };
+		struct Access {
+			GraphResource			   Resource;
+			AccessKind				   Kind;
+			ResourceUsage			   Usage;
+			bool					   Reads;	//depends on what earlier passes wrote
+			bool					   Writes;
+			std::optional<VkClearValue> Clear;
+		};
+		struct ResourceNode {
+			std::string				 Name;
+			GraphImageDesc			 Desc;
+			bool					 Imported  = false;
+			bool					 Output	   = false;
+			std::vector<VkImage>	 Images;	//one for transient images
+			std::vector<VkImageView> Views;
+			ResourceUsage			 Initial;
+			ResourceUsage			 Final;
+			VkImageUsageFlags		 Usage	   = 0;
+			uint32_t				 FirstPass = UINT32_MAX;	//positions in Order
+			uint32_t				 LastPass  = 0;
+		};
+		struct PassNode {
+			std::string				   Name;
+			PassType				   Type;
+			PassRecorder			   Recorder;
+			VkSubpassContents		   Contents;
+			std::vector<Access>		   Accesses;
+			bool					   Culled	   = false;
+			VkRenderPass			   RenderPass  = VK_NULL_HANDLE;
+			std::vector<VkFramebuffer> Framebuffers;	//one per variant
+			std::vector<VkClearValue>  ClearValues;		//one per attachment
+			VkExtent2D				   Extent	   = {};
+		};
+
+		void AddAccess(GraphPass pass, const Access& access);
+		bool SortPasses();
+		void CullPasses();
+		bool CreateImages();
+		bool CreateRenderPass(PassNode& pass, uint32_t position);
+		bool CreateFramebuffers(PassNode& pass);
+		//Destroys the framebuffers and the graph's own images and views; imported images are left alone.
+		void DestroyImages();
+		bool IsWrittenBefore(GraphResource resource, uint32_t position) const;
+		bool IsAccessedAfter(GraphResource resource, uint32_t position) const;
+		VkImage ImageOf(const ResourceNode& resource, uint32_t variant) const;
+
+		const LogicalDevice*	  Device		  = nullptr;
+		TransientImagePool*		  TransientImages = nullptr;
+		ResourceStateTracker*	  States		  = nullptr;
+		std::vector<ResourceNode> Resources;
+		std::vector<PassNode>	  Passes;
+		std::vector<GraphPass>	  Order;			//executed passes
+		ResourceUsage			  AliasedUsage;		//every access to a transient image; what an aliasing image may still be doing
+		bool					  Compiled		  = false;
+		RenderGraphStats		  Statistics;
+	};
+}
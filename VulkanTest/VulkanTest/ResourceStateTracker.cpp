@@ -0,0 +1,267 @@
+#include "ResourceStateTracker.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	namespace {
+		const VkAccessFlags WriteAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+											  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+											  VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	}
+
+	void ResourceStateTracker::Create(const LogicalDevice& device) {
+		Device = &device;
+		Batch = 1;
+		Statistics = {};
+	}
+
+	void ResourceStateTracker::Destroy() {
+		Images.clear();
+		Buffers.clear();
+		ImageBarriers.clear();
+		BufferBarriers.clear();
+		SrcStages = DstStages = 0;
+		Device = nullptr;
+	}
+
+	void ResourceStateTracker::RegisterImage(VkImage image, uint32_t mipLevels, uint32_t arrayLayers, const ResourceUsage& current) {
+		ImageState& state = Images[image];
+		state.MipLevels = mipLevels;
+		state.Subresources.assign(static_cast<size_t>(mipLevels) * arrayLayers, AccessState());
+		for (auto& subresource : state.Subresources)
+			Apply(subresource, current, true);
+	}
+
+	void ResourceStateTracker::RegisterBuffer(VkBuffer buffer, VkDeviceSize size, const ResourceUsage& current) {
+		BufferSegment segment;
+		segment.Size = size;
+		Apply(segment.State, current, false);
+		Buffers[buffer] = { segment };
+	}
+
+	void ResourceStateTracker::ForgetImage(VkImage image) {
+		Images.erase(image);
+	}
+
+	void ResourceStateTracker::ForgetBuffer(VkBuffer buffer) {
+		Buffers.erase(buffer);
+	}
+
+	//Writes and layout transitions wait for every earlier access; reads only for a write they cannot see yet.
+	bool ResourceStateTracker::FindHazard(const AccessState& state, const ResourceUsage& usage, bool image, Hazard& hazard) {
+		bool transition = image && usage.Layout != state.Layout;
+		if (transition || (usage.Access & WriteAccessMask)) {
+			hazard.SrcStages = state.WriteStages | state.ReadStages;
+			hazard.SrcAccess = state.WriteAccess;
+			hazard.Barrier = transition || state.WriteAccess != 0;
+		} else if (state.WriteStages && ((usage.Stages & ~state.VisibleStages) || (usage.Access & ~state.VisibleAccess))) {
+			hazard.SrcStages = state.WriteStages;
+			hazard.SrcAccess = state.WriteAccess;
+			hazard.Barrier = state.WriteAccess != 0;
+		} else
+			return false;
+		return hazard.Barrier || hazard.SrcStages != 0;
+	}
+
+	void ResourceStateTracker::Apply(AccessState& state, const ResourceUsage& usage, bool image) {
+		VkAccessFlags writes = usage.Access & WriteAccessMask;
+		if (writes || (image && usage.Layout != state.Layout)) {
+			//a layout transition is a write as well, one the barrier has already made visible to usage
+			if (image)
+				state.Layout = usage.Layout;
+			state.WriteStages = usage.Stages;
+			state.WriteAccess = writes;
+			state.VisibleStages = writes ? 0 : usage.Stages;
+			state.VisibleAccess = writes ? 0 : usage.Access;
+			state.ReadStages = writes ? 0 : usage.Stages;
+		} else {
+			state.VisibleStages |= usage.Stages;
+			state.VisibleAccess |= usage.Access;
+			state.ReadStages |= usage.Stages;
+		}
+	}
+
+	bool ResourceStateTracker::UseImage(VkCommandBuffer commandBuffer, VkImage image, const VkImageSubresourceRange& range, const ResourceUsage& usage) {
+		auto found = Images.find(image);
+		if (found == Images.end()) {
+			std::cout << "The state of the image is not tracked." << std::endl;
+			return false;
+		}
+		ImageState& state = found->second;
+		uint32_t arrayLayers = static_cast<uint32_t>(state.Subresources.size()) / state.MipLevels;
+		uint32_t levelCount = range.levelCount == VK_REMAINING_MIP_LEVELS ? state.MipLevels - range.baseMipLevel : range.levelCount;
+		uint32_t layerCount = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? arrayLayers - range.baseArrayLayer : range.layerCount;
+		if (range.baseMipLevel >= state.MipLevels || levelCount > state.MipLevels - range.baseMipLevel ||
+			range.baseArrayLayer >= arrayLayers || layerCount > arrayLayers - range.baseArrayLayer) {
+			std::cout << "The subresource range is outside of the image." << std::endl;
+			return false;
+		}
+		uint32_t levelEnd = range.baseMipLevel + levelCount;
+		uint32_t layerEnd = range.baseArrayLayer + layerCount;
+		auto subresource = [&](uint32_t layer, uint32_t level) -> AccessState& {
+			return state.Subresources[static_cast<size_t>(layer) * state.MipLevels + level];
+		};
+
+		Hazard hazard;
+		//two barriers for one subresource in one vkCmdPipelineBarrier would not be ordered
+		for (uint32_t layer = range.baseArrayLayer; layer < layerEnd; ++layer)
+			for (uint32_t level = range.baseMipLevel; level < levelEnd; ++level)
+				if (subresource(layer, level).Batch == Batch && FindHazard(subresource(layer, level), usage, true, hazard)) {
+					Flush(commandBuffer);
+					layer = layerEnd;
+					break;
+				}
+
+		//consecutive levels with the same previous state share one barrier
+		for (uint32_t layer = range.baseArrayLayer; layer < layerEnd; ++layer)
+			for (uint32_t level = range.baseMipLevel; level < levelEnd;) {
+				AccessState& first = subresource(layer, level);
+				if (!FindHazard(first, usage, true, hazard)) {
+					Apply(first, usage, true);
+					++level;
+					continue;
+				}
+				VkImageLayout oldLayout = first.Layout;
+				uint32_t last = level + 1;
+				Hazard next;
+				while (last < levelEnd && subresource(layer, last).Layout == oldLayout && FindHazard(subresource(layer, last), usage, true, next) &&
+					   next.Barrier == hazard.Barrier && next.SrcAccess == hazard.SrcAccess) {
+					hazard.SrcStages |= next.SrcStages;
+					++last;
+				}
+				if (hazard.Barrier) {
+					ImageBarriers.push_back({
+						VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,				//sType
+						nullptr,											//pNext
+						hazard.SrcAccess,									//srcAccessMask
+						usage.Access,										//dstAccessMask
+						oldLayout,											//oldLayout
+						usage.Layout,										//newLayout
+						VK_QUEUE_FAMILY_IGNORED,							//srcQueueFamilyIndex
+						VK_QUEUE_FAMILY_IGNORED,							//dstQueueFamilyIndex
+						image,												//image
+						{ range.aspectMask, level, last - level, layer, 1 }	//subresourceRange
+					});
+					++Statistics.ImageBarriers;
+				}
+				SrcStages |= hazard.SrcStages;
+				DstStages |= usage.Stages;
+				for (; level < last; ++level) {
+					Apply(subresource(layer, level), usage, true);
+					subresource(layer, level).Batch = Batch;
+				}
+			}
+		return true;
+	}
+
+	size_t ResourceStateTracker::Split(std::vector<BufferSegment>& segments, VkDeviceSize offset, VkDeviceSize size) {
+		auto splitAt = [&segments](VkDeviceSize at) {
+			auto next = std::upper_bound(segments.begin(), segments.end(), at, [](VkDeviceSize value, const BufferSegment& segment) {
+				return value < segment.Offset;
+			});
+			size_t index = static_cast<size_t>(next - segments.begin()) - 1;
+			BufferSegment& segment = segments[index];
+			if (segment.Offset == at)
+				return index;
+			if (at >= segment.Offset + segment.Size)
+				return segments.size();
+			BufferSegment tail = segment;
+			tail.Offset = at;
+			tail.Size = segment.Offset + segment.Size - at;
+			segment.Size = at - segment.Offset;
+			segments.insert(segments.begin() + index + 1, tail);
+			return index + 1;
+		};
+		size_t first = splitAt(offset);
+		splitAt(offset + size);
+		return first;
+	}
+
+	bool ResourceStateTracker::UseBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const ResourceUsage& usage) {
+		auto found = Buffers.find(buffer);
+		if (found == Buffers.end()) {
+			std::cout << "The state of the buffer is not tracked." << std::endl;
+			return false;
+		}
+		std::vector<BufferSegment>& segments = found->second;
+		VkDeviceSize bufferSize = segments.back().Offset + segments.back().Size;
+		if (size == VK_WHOLE_SIZE && offset < bufferSize)
+			size = bufferSize - offset;
+		if (offset >= bufferSize || size == 0 || size > bufferSize - offset) {
+			std::cout << "The range is outside of the buffer." << std::endl;
+			return false;
+		}
+		VkDeviceSize end = offset + size;
+		size_t first = Split(segments, offset, size);
+
+		Hazard hazard;
+		for (size_t index = first; index < segments.size() && segments[index].Offset < end; ++index)
+			if (segments[index].State.Batch == Batch && FindHazard(segments[index].State, usage, false, hazard)) {
+				Flush(commandBuffer);
+				break;
+			}
+
+		for (size_t index = first; index < segments.size() && segments[index].Offset < end;) {
+			if (!FindHazard(segments[index].State, usage, false, hazard)) {
+				Apply(segments[index].State, usage, false);
+				++index;
+				continue;
+			}
+			size_t last = index + 1;
+			Hazard next;
+			while (last < segments.size() && segments[last].Offset < end && FindHazard(segments[last].State, usage, false, next) &&
+				   next.Barrier == hazard.Barrier && next.SrcAccess == hazard.SrcAccess) {
+				hazard.SrcStages |= next.SrcStages;
+				++last;
+			}
+			if (hazard.Barrier) {
+				BufferBarriers.push_back({
+					VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,										//sType
+					nullptr,																		//pNext
+					hazard.SrcAccess,																//srcAccessMask
+					usage.Access,																	//dstAccessMask
+					VK_QUEUE_FAMILY_IGNORED,														//srcQueueFamilyIndex
+					VK_QUEUE_FAMILY_IGNORED,														//dstQueueFamilyIndex
+					buffer,																			//buffer
+					segments[index].Offset,															//offset
+					segments[last - 1].Offset + segments[last - 1].Size - segments[index].Offset	//size
+				});
+				++Statistics.BufferBarriers;
+			}
+			SrcStages |= hazard.SrcStages;
+			DstStages |= usage.Stages;
+			for (; index < last; ++index) {
+				Apply(segments[index].State, usage, false);
+				segments[index].State.Batch = Batch;
+			}
+		}
+
+		//segments that ended up in the same state are merged again, so a buffer used whole stays one segment
+		auto sameState = [](const AccessState& a, const AccessState& b) {
+			return a.WriteStages == b.WriteStages && a.WriteAccess == b.WriteAccess && a.VisibleStages == b.VisibleStages &&
+				   a.VisibleAccess == b.VisibleAccess && a.ReadStages == b.ReadStages && a.Batch == b.Batch;
+		};
+		for (size_t index = first > 0 ? first - 1 : 0; index + 1 < segments.size() && segments[index].Offset < end;) {
+			if (sameState(segments[index].State, segments[index + 1].State)) {
+				segments[index].Size += segments[index + 1].Size;
+				segments.erase(segments.begin() + index + 1);
+			} else
+				++index;
+		}
+		return true;
+	}
+
+	void ResourceStateTracker::Flush(VkCommandBuffer commandBuffer) {
+		if (!SrcStages && ImageBarriers.empty() && BufferBarriers.empty())
+			return;
+		//transitions out of VK_IMAGE_LAYOUT_UNDEFINED have nothing to wait for
+		Device->Dispatch.vkCmdPipelineBarrier(commandBuffer,
+			SrcStages ? SrcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, DstStages ? DstStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr,
+			static_cast<uint32_t>(BufferBarriers.size()), BufferBarriers.data(),
+			static_cast<uint32_t>(ImageBarriers.size()), ImageBarriers.data());
+		++Statistics.Flushes;
+		ImageBarriers.clear();
+		BufferBarriers.clear();
+		SrcStages = DstStages = 0;
+		++Batch;
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "Common.h"
+namespace VulkanCookbook {
+	//How the next command accesses a resource. Layout is ignored for buffers.
+	struct ResourceUsage {
+		VkPipelineStageFlags Stages = 0;
+		VkAccessFlags		 Access = 0;
+		VkImageLayout		 Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	};
+
+	namespace Usage {
+		const ResourceUsage TransferRead			 = { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL };
+		const ResourceUsage TransferWrite			 = { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL };
+		const ResourceUsage VertexBufferRead		 = { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT };
+		const ResourceUsage IndexBufferRead			 = { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT };
+		const ResourceUsage UniformRead				 = { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_UNIFORM_READ_BIT };
+		const ResourceUsage FragmentShaderRead		 = { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		const ResourceUsage ComputeShaderRead		 = { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		const ResourceUsage ComputeShaderWrite		 = { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL };
+		const ResourceUsage ColorAttachmentWrite	 = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+														 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		const ResourceUsage DepthStencilAttachment	 = { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+														 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+														 VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+		const ResourceUsage Present					 = { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR };
+	}
+
+	struct ResourceStateStats {
+		uint64_t Flushes		= 0;	//vkCmdPipelineBarrier calls
+		uint64_t ImageBarriers	= 0;
+		uint64_t BufferBarriers = 0;
+	};
+
+	//Knows the layout and the last accesses of every subresource of the registered images and of every
+	//range of the registered buffers. Use* compares the current state with the requested usage and queues
+	//only the barriers the hazard needs: a layout transition or a write after anything, a read of a write
+	//that is not yet visible to its stage, and nothing for reads after reads. Queued barriers go into the
+	//command buffer as one vkCmdPipelineBarrier on Flush, which must come before the commands using them.
+	//The state assumes command buffers execute in the order they are recorded in, e.g. all on one queue.
+	//Not thread-safe.
+	class ResourceStateTracker {
+	 public:
+		void Create(const LogicalDevice& device);
+		void Destroy();
+
+		//current is the usage of the last command that accessed the whole resource, if any.
+		void RegisterImage(VkImage image, uint32_t mipLevels, uint32_t arrayLayers, const ResourceUsage& current = {});
+		void RegisterBuffer(VkBuffer buffer, VkDeviceSize size, const ResourceUsage& current = {});
+		void ForgetImage(VkImage image);
+		void ForgetBuffer(VkBuffer buffer);
+
+		//A subresource may only change state once per batch; a second change flushes the batch into
+		//commandBuffer first. VK_REMAINING_MIP_LEVELS, VK_REMAINING_ARRAY_LAYERS and VK_WHOLE_SIZE are allowed.
+		bool UseImage(VkCommandBuffer commandBuffer, VkImage image, const VkImageSubresourceRange& range, const ResourceUsage& usage);
+		bool UseBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const ResourceUsage& usage);
+		void Flush(VkCommandBuffer commandBuffer);
+
+		const ResourceStateStats& Stats() const { return Statistics; }
+	 private:
+		struct AccessState {
+			VkImageLayout		 Layout		   = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags WriteStages   = 0;	//of the last write or layout transition
+			VkAccessFlags		 WriteAccess   = 0;
+			VkPipelineStageFlags VisibleStages = 0;	//the last write has been made visible to these
+			VkAccessFlags		 VisibleAccess = 0;
+			VkPipelineStageFlags ReadStages	   = 0;	//since the last write
+			uint64_t			 Batch		   = 0;	//of its last queued barrier
+		};
+		struct Hazard {
+			bool				 Barrier   = false;	//needs a buffer or image barrier, not only an execution dependency
+			VkPipelineStageFlags SrcStages = 0;
+			VkAccessFlags		 SrcAccess = 0;
+		};
+		struct ImageState {
+			uint32_t				 MipLevels = 0;
+			std::vector<AccessState> Subresources;	//layer * MipLevels + level
+		};
+		struct BufferSegment {
+			VkDeviceSize Offset = 0;
+			VkDeviceSize Size	= 0;
+			AccessState	 State;
+		};
+
+		static bool FindHazard(const AccessState& state, const ResourceUsage& usage, bool image, Hazard& hazard);
+		static void Apply(AccessState& state, const ResourceUsage& usage, bool image);
+		//Splits segments so that offset and offset + size are segment boundaries; returns the first in the range.
+		static size_t Split(std::vector<BufferSegment>& segments, VkDeviceSize offset, VkDeviceSize size);
+
+		const LogicalDevice*									 Device = nullptr;
+		std::unordered_map<VkImage, ImageState>					 Images;
+		std::unordered_map<VkBuffer, std::vector<BufferSegment>> Buffers;	//segments sorted by offset, covering the buffer
+		std::vector<VkImageMemoryBarrier>						 ImageBarriers;
+		std::vector<VkBufferMemoryBarrier>						 BufferBarriers;
+		VkPipelineStageFlags									 SrcStages = 0;
+		VkPipelineStageFlags									 DstStages = 0;
+		uint64_t												 Batch	   = 1;
+		ResourceStateStats										 Statistics;
+	};
+}
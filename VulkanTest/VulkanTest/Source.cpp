@@ -1,18 +1,6 @@
-//********************************
-//TUTORIAL NR.2 (VULKAN OFFICIAL GUIDE)
-//********************************
-#include "vkapp.h"
-#include <iostream>
-#include <vector>
-int main() {
-
-}
-
-
 //********************************
 //TUTORIAL NR.1
 //********************************
-/*VULKAN TUTORIAL 1
 
 #define GLFW_INCLUDE_VULKAN
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -41,6 +29,22 @@ int main() {
 #include <fstream>	
 #include <array>
 #include <unordered_map>
+#include "vkapp.h"
+#include "UniformRingBuffer.h"
+#include "StagingHeap.h"
+#include "MemoryDefragmenter.h"
+#include "TransientImagePool.h"
+#include "FrameCommandPools.h"
+#include "ParallelCommandRecorder.h"
+#include "ResourceStateTracker.h"
+#include "RenderGraph.h"
+#include "FrameTimeline.h"
+#include "JobSystem.h"
+#include "CommandCache.h"
+#ifdef VK_NO_PROTOTYPES
+//without the loader's prototypes the calls below go to the entry points vkapp loads
+using namespace VulkanCookbook;
+#endif
 
 
 
@@ -51,6 +55,11 @@ struct QueueFamilyIndices {
 		return graphicsFamily.has_value() && presentFamily.has_value();
 	}
 };
+//one indexed draw per shape of the model
+struct MeshDraw {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+};
 struct SwapChainSupportDetails {
 	VkSurfaceCapabilitiesKHR capabilities;
 	std::vector<VkSurfaceFormatKHR> formats;
@@ -113,9 +122,15 @@ struct UniformBufferObject {
 
 class HelloTriangleApplication {
 public:
-	void run() {
+	void run(const VulkanCookbook::FramePacing& pacing = VulkanCookbook::FramePacing::Throughput()) {
+		framePacing = pacing;
 		initWindow();
-		initVulkan();
+		{
+			VulkanCookbook::ScopedTimer timer(initTime);
+			initVulkan();
+		}
+		std::cout << "initVulkan: " << initTime.count() << " ms, " << transfers.Stats().Submits << " transfer submit(s), "
+				  << transfers.Stats().HostWaits << " host wait(s)" << std::endl;
 		mainLoop();
 		cleanup();
 	}
@@ -133,6 +148,8 @@ private:
 		app->framebufferResized = true;
 	}
 	void initVulkan() {
+		createJobSystem();
+		startLoadingAssets();
 		createInstance();
 		setupDebugCallback();
 		createSurface();
@@ -140,86 +157,80 @@ private:
 		createLogicalDevice();
 		createSwapChain();
 		createImageViews();
-		createRenderPass();
+		buildRenderGraph();
 		createDescriptorSetLayout();
 		createGraphicsPipeLine();
 		createCommandPool();
-		createColorResources();
-		createDepthResources();
-		createFramebuffers();
+		createStagingHeap();
+		createDefragmenter();
+		finishLoadingAssets();
 		createTextureImage();
 		createTextureImageView();
 		createTextureSampler();
-		loadModel();
 		createVertexBuffer();
 		createIndexBuffer();
+		submitUploads();
 		createUniformBuffer();
 		createDescriptorPool();
 		createDescriptorSets();
-		createCommandBuffers();
 		createSyncObjects();
 	}
 	VkSampleCountFlagBits getMaxUsableSampleCount() {
-		VkPhysicalDeviceProperties physicalDeviceProperties;
-		vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
-
-		VkSampleCountFlags counts = std::min(physicalDeviceProperties.limits.framebufferColorSampleCounts,
-											 physicalDeviceProperties.limits.framebufferDepthSampleCounts);
-
-		if (counts & VK_SAMPLE_COUNT_64_BIT) return VK_SAMPLE_COUNT_64_BIT;
-		if (counts & VK_SAMPLE_COUNT_32_BIT) return VK_SAMPLE_COUNT_32_BIT;
-		if (counts & VK_SAMPLE_COUNT_16_BIT) return VK_SAMPLE_COUNT_16_BIT;
-		if (counts & VK_SAMPLE_COUNT_8_BIT) return VK_SAMPLE_COUNT_8_BIT;
-		if (counts & VK_SAMPLE_COUNT_4_BIT) return VK_SAMPLE_COUNT_4_BIT;
-		if (counts & VK_SAMPLE_COUNT_2_BIT) return VK_SAMPLE_COUNT_2_BIT;
-
-		return VK_SAMPLE_COUNT_1_BIT;
-	}
-	void createColorResources() {
-		VkFormat colorFormat = swapChainImageFormat;
-
-		createImage(swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, colorFormat, VK_IMAGE_TILING_OPTIMAL,
-					VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage, colorImageMemory);
-		colorImageView = createImageView(colorImage, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-		
-		transitionImageLayout(colorImage, colorFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 1);
+		return physicalDeviceInfo->MaxUsableSampleCount();
+	}
+	//One pass draws the scene into the MSAA color and depth images and resolves into the swapchain image.
+	//Neither MSAA image reaches a later pass, so the graph gives them no store op and puts them in
+	//transient memory; the swapchain image waits for the acquire semaphore's stage and ends up presentable.
+	void buildRenderGraph() {
+		VulkanCookbook::GraphImageDesc sceneDesc = { swapChainImageFormat, swapChainExtent, msaaSamples };
+		VulkanCookbook::GraphImageDesc depthDesc = { findDepthFormat(), swapChainExtent, msaaSamples };
+		VulkanCookbook::GraphImageDesc backbufferDesc = { swapChainImageFormat, swapChainExtent, VK_SAMPLE_COUNT_1_BIT };
+
+		sceneColor = renderGraph.CreateImage("msaa color", sceneDesc);
+		sceneDepth = renderGraph.CreateImage("depth", depthDesc);
+		backbuffer = renderGraph.ImportImage("swapchain", swapChainImages, swapChainImageViews, backbufferDesc,
+			{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED }, VulkanCookbook::Usage::Present);
+
+		scenePass = renderGraph.AddPass("scene", VulkanCookbook::PassType::Graphics,
+			[this](const VulkanCookbook::PassContext& context) { return recordScene(context); }, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		renderGraph.ColorAttachment(scenePass, sceneColor, VkClearColorValue{ { 0.0f, 0.0f, 0.0f, 1.0f } });
+		renderGraph.DepthAttachment(scenePass, sceneDepth, VkClearDepthStencilValue{ 1.0f, 0 });
+		renderGraph.ResolveAttachment(scenePass, backbuffer);
+		renderGraph.MarkOutput(backbuffer);
+
+		if (!renderGraph.Compile())
+			throw std::runtime_error("failed to compile render graph!");
+		renderPass = renderGraph.RenderPass(scenePass);
+	}
+	//the render pass and the pipeline made for it do not depend on the size, only the images and
+	//framebuffers do
+	void resizeRenderGraph() {
+		renderGraph.ResizeImage(sceneColor, swapChainExtent);
+		renderGraph.ResizeImage(sceneDepth, swapChainExtent);
+		renderGraph.ReimportImage(backbuffer, swapChainImages, swapChainImageViews, swapChainExtent);
+		if (!renderGraph.Resize())
+			throw std::runtime_error("failed to resize render graph!");
 	}
 	void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
-		VkFormatProperties formatProperties;
-		vkGetPhysicalDeviceFormatProperties(physicalDevice, imageFormat, &formatProperties);
+		const VkFormatProperties& formatProperties = physicalDeviceInfo->FormatProperties(imageFormat);
 
 		if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
 			throw std::runtime_error("texture image format does not support linear blitting!");
 		}
 
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkImageMemoryBarrier barrier = {};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.image = image;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-		barrier.subresourceRange.levelCount = 1;
+		VkCommandBuffer commandBuffer = transfers.Commands();
+		if (!commandBuffer)
+			throw std::runtime_error("failed to record mipmap generation!");
 
 		int32_t mipWidth = texWidth;
 		int32_t mipHeight = texHeight;
 
+		//each blit reads the level the previous one wrote, so one flush per level is the minimum
 		for (uint32_t i = 1; i < mipLevels; i++) {
-			barrier.subresourceRange.baseMipLevel = i - 1;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-			vkCmdPipelineBarrier(commandBuffer,
-				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier);
+			if (!resourceStates.UseImage(commandBuffer, image, { VK_IMAGE_ASPECT_COLOR_BIT, i - 1, 1, 0, 1 }, VulkanCookbook::Usage::TransferRead) ||
+				!resourceStates.UseImage(commandBuffer, image, { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 }, VulkanCookbook::Usage::TransferWrite))
+				throw std::runtime_error("failed to record mipmap generation!");
+			resourceStates.Flush(commandBuffer);
 
 			VkImageBlit blit = {};
 			blit.srcOffsets[0] = { 0, 0, 0 };
@@ -241,34 +252,41 @@ private:
 				1, &blit,
 				VK_FILTER_LINEAR);
 
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			vkCmdPipelineBarrier(commandBuffer,
-				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier);
-
 			if (mipWidth > 1) mipWidth /= 2;
 			if (mipHeight > 1) mipHeight /= 2;
 		}
 
-		barrier.subresourceRange.baseMipLevel = mipLevels - 1;
-		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		vkCmdPipelineBarrier(commandBuffer,
-			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier);
-
-		endSingleTimeCommands(commandBuffer);
+		//one barrier call for the whole chain: the blit sources come from TRANSFER_SRC, the last level from TRANSFER_DST
+		if (!resourceStates.UseImage(commandBuffer, image, { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 }, VulkanCookbook::Usage::FragmentShaderRead))
+			throw std::runtime_error("failed to record mipmap generation!");
+		resourceStates.Flush(commandBuffer);
+	}
+	//capped: recording one frame's draws stops scaling after a few threads
+	void createJobSystem() {
+		if (!jobs.Create(std::max(std::min(std::thread::hardware_concurrency(), MAX_JOB_THREADS), 1u)))
+			throw std::runtime_error("failed to start job threads!");
+	}
+	//The model is parsed and the texture decoded on job threads while the main thread sets up the
+	//device; neither needs Vulkan, and each job only writes its own members.
+	void startLoadingAssets() {
+		jobs.Run([this] {
+			try {
+				loadModel();
+			} catch (const std::exception& error) {
+				modelError = error.what();
+			}
+		}, &assetsLoaded);
+		jobs.Run([this] {
+			int texChannels;
+			texturePixels = stbi_load(TEXTURE_PATH.c_str(), &textureWidth, &textureHeight, &texChannels, STBI_rgb_alpha);
+		}, &assetsLoaded);
+	}
+	void finishLoadingAssets() {
+		jobs.Wait(assetsLoaded);
+		if (!modelError.empty())
+			throw std::runtime_error(modelError);
+		if (!texturePixels)
+			throw std::runtime_error("failed to load texture image!");
 	}
 	void loadModel() {
 		tinyobj::attrib_t attrib;
@@ -280,7 +298,8 @@ private:
 			throw std::runtime_error(err);
 		std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
 
-		for(const auto& shape : shapes)
+		for (const auto& shape : shapes) {
+			MeshDraw draw = { static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(shape.mesh.indices.size()) };
 			for (const auto& index : shape.mesh.indices) {
 				Vertex vertex = {};
 
@@ -303,33 +322,19 @@ private:
 
 				indices.push_back(uniqueVertices[vertex]);
 			}
+			if (draw.indexCount > 0)
+				meshDraws.push_back(draw);
+		}
 
 	}
-	void createDepthResources() {
-		VkFormat depthFormat = findDepthFormat();
-
-		createImage(swapChainExtent.width, swapChainExtent.height, 1, msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL,
-					VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
-		depthImageView = createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
-
-		transitionImageLayout(depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
-	}
 	bool hasStencilComponent(VkFormat format) {
 		return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 	}
 	VkFormat findSuportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) {
-		for (VkFormat format : candidates) {
-			VkFormatProperties props;
-			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
-			if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features)
-				return format;
-			
-			else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features) 
-				return format;
-			
-		}
-		throw std::runtime_error("failed to find suported format!");
-	
+		VkFormat format;
+		if (!physicalDeviceInfo->FindSupportedFormat(candidates, tiling, features, format))
+			throw std::runtime_error("failed to find suported format!");
+		return format;
 	}
 	VkFormat findDepthFormat() {
 		return findSuportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
@@ -355,7 +360,7 @@ private:
 		samplerInfo.maxLod = static_cast<float>(mipLevels);
 		samplerInfo.mipLodBias = 0;
 
-		if (vkCreateSampler(device, &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS)
+		if (vkCreateSampler(device, &samplerInfo, logicalDevice.HostCallbacks, &textureSampler) != VK_SUCCESS)
 			throw std::runtime_error("failed to create texture sampler!");
 	}
 	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
@@ -371,7 +376,7 @@ private:
 		viewInfo.subresourceRange.layerCount = 1;
 
 		VkImageView imageView;
-		if (vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+		if (vkCreateImageView(device, &viewInfo, logicalDevice.HostCallbacks, &imageView) != VK_SUCCESS)
 			throw std::runtime_error("failed to create texture image view!");
 		return imageView;
 	}
@@ -379,39 +384,32 @@ private:
 		textureImageView = createImageView(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
 	}
 	void createTextureImage() {
-		int texWidth, texHeight, texChannels;
-		stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		int texWidth = textureWidth, texHeight = textureHeight;
 		VkDeviceSize imageSize = texWidth * texHeight * 4;
 		mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
-		if (!pixels) {
-			throw std::runtime_error("failed to load texture image!");
-		}
-
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+		createImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VulkanCookbook::MemoryCategory::Texture, textureImage, textureImageMemory);
 
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
-		memcpy(data, pixels, static_cast<size_t>(imageSize));
-		vkUnmapMemory(device, stagingBufferMemory);
-
-		stbi_image_free(pixels);
-
-		createImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
-
-		transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
-		copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+		VkBufferImageCopy region = {};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1 };
+		//moves every mip level to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL before the copy
+		if (!stagingHeap.UploadToImage(texturePixels, imageSize, textureImage, region, { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 }))
+			throw std::runtime_error("failed to upload texture image!");
+		stbi_image_free(texturePixels);
+		texturePixels = nullptr;
+		//the blits below read level 0, so its copy is recorded into the same batch ahead of them
+		if (!stagingHeap.Record())
+			throw std::runtime_error("failed to upload texture image!");
+		//Record ends with a barrier that makes the copy visible to every later command
+		resourceStates.RegisterImage(textureImage, mipLevels, 1, { VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL });
 		//transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
 
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
-
 		generateMipmaps(textureImage, VK_FORMAT_R8G8B8A8_UNORM, texWidth, texHeight, mipLevels);
 	}
 	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, 
-		VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory) {
+		VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VulkanCookbook::MemoryCategory category,
+		VkImage& image, VulkanCookbook::Allocation& imageMemory) {
 		
 		VkImageCreateInfo imageInfo = {};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -429,22 +427,11 @@ private:
 		imageInfo.samples = numSamples;
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+		VulkanCookbook::AllocationCreateInfo allocInfo;
+		allocInfo.RequiredFlags = properties;
+		allocInfo.Category = category;
+		if (!allocator->CreateImage(imageInfo, allocInfo, image, imageMemory))
 			throw std::runtime_error("failed to create image!");
-
-
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(device, image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-			throw std::runtime_error("failed to allocate image memory!");
-
-		vkBindImageMemory(device, image, imageMemory, 0);
 	}
 	void createDescriptorSets() {
 		std::vector<VkDescriptorSetLayout> layouts(swapChainImages.size(), descriptorSetLayout);
@@ -461,7 +448,7 @@ private:
 
 		for (size_t i = 0; i < swapChainImages.size(); ++i) {
 			VkDescriptorBufferInfo bufferInfo = {};
-			bufferInfo.buffer = uniformBuffers[i];
+			bufferInfo.buffer = uniformRing.Buffer();
 			bufferInfo.offset = 0;
 			bufferInfo.range = sizeof(UniformBufferObject);
 
@@ -476,7 +463,7 @@ private:
 			descriptorWrite[0].dstSet = descriptorSets[i];
 			descriptorWrite[0].dstBinding = 0;
 			descriptorWrite[0].dstArrayElement = 0;
-			descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 			descriptorWrite[0].descriptorCount = 1;
 			descriptorWrite[0].pBufferInfo = &bufferInfo;
 			descriptorWrite[0].pImageInfo = nullptr;
@@ -498,7 +485,7 @@ private:
 	}
 	void createDescriptorPool() {
 		std::array<VkDescriptorPoolSize, 2> poolSize = {};
-		poolSize[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		poolSize[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		poolSize[0].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
 		poolSize[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		poolSize[1].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
@@ -510,24 +497,19 @@ private:
 		poolInfo.maxSets = static_cast<uint32_t>(swapChainImages.size());
 
 
-		if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+		if (vkCreateDescriptorPool(device, &poolInfo, logicalDevice.HostCallbacks, &descriptorPool) != VK_SUCCESS)
 			throw std::runtime_error("failed to create descriptor pool!");
 	}
 	void createUniformBuffer() {
-		VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-		uniformBuffers.resize(swapChainImages.size());
-		uniformBuffersMemory.resize(swapChainImages.size());
-
-		for (size_t i = 0; i < swapChainImages.size(); ++i)
-			createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-				VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
+		//one partition per swapchain image, sized for every object drawn in a frame
+		if (!uniformRing.Create(*allocator, sizeof(UniformBufferObject), static_cast<uint32_t>(swapChainImages.size())))
+			throw std::runtime_error("failed to create uniform ring buffer!");
 	}
 	void createDescriptorSetLayout() {
 		VkDescriptorSetLayoutBinding uboLayoutBinding = {};
 		uboLayoutBinding.binding = 0;
 		uboLayoutBinding.descriptorCount = 1;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		uboLayoutBinding.pImmutableSamplers = nullptr;
 		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -545,155 +527,54 @@ private:
 		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
 		layoutInfo.pBindings = bindings.data();
 
-		if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+		if (vkCreateDescriptorSetLayout(device, &layoutInfo, logicalDevice.HostCallbacks, &descriptorSetLayout) != VK_SUCCESS)
 			throw std::runtime_error("failed to create descriptor set layout!");
 	}
 	void createIndexBuffer() {
 		VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			stagingBuffer, stagingBufferMemory);
-
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, indices.data(), static_cast<size_t>(bufferSize));
-		vkUnmapMemory(device, stagingBufferMemory);
-
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			indexBuffer, indexBufferMemory);
-
-		copyBuffer(stagingBuffer, indexBuffer, bufferSize);
-
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
+		VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		VulkanCookbook::Allocation indexBufferMemory;
+		createBuffer(bufferSize, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VulkanCookbook::MemoryCategory::Geometry, indexBuffer, indexBufferMemory, directWriteMemoryFlags, true);
+		if (!stagingHeap.UploadToBuffer(indices.data(), bufferSize, indexBuffer, indexBufferMemory))
+			throw std::runtime_error("failed to upload index buffer!");
+		makeBufferMovable(bufferSize, usage, indexBufferMemory, indexBuffer, indexBufferHandle);
 	}
 	void createVertexBuffer() {
 		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
 
-		VkBuffer stagingBuffer = {};
-		VkDeviceMemory stagingBufferMemory = {};
-
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-		void* data;
-		vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-		memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-		vkUnmapMemory(device, stagingBufferMemory);
-
-		createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
-
-		copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
-
-		vkDestroyBuffer(device, stagingBuffer, nullptr);
-		vkFreeMemory(device, stagingBufferMemory, nullptr);
-	}
-	void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels) {
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkImageMemoryBarrier barrier = {};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = oldLayout;
-		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = image;
-
-		if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-
-			if (hasStencilComponent(format)) {
-				barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-			}
-		}
-		else {
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		}
-
-		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = mipLevels;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-
-		VkPipelineStageFlags sourceStage;
-		VkPipelineStageFlags destinationStage;
-
-		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL) {
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		}
-		else 
-			throw std::invalid_argument("unsupported layout transition!");
-		
-
-		vkCmdPipelineBarrier(
-			commandBuffer,
-			sourceStage, destinationStage,
-			0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier
-		);
-
-		endSingleTimeCommands(commandBuffer);
-	}
-	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {		
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-		VkBufferCopy copyRegion = {};
-		copyRegion.srcOffset = 0;
-		copyRegion.dstOffset = 0;
-		copyRegion.size = size;
-		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+		VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		VulkanCookbook::Allocation vertexBufferMemory;
+		createBuffer(bufferSize, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VulkanCookbook::MemoryCategory::Geometry,
+			vertexBuffer, vertexBufferMemory, directWriteMemoryFlags, true);
+		if (!stagingHeap.UploadToBuffer(vertices.data(), bufferSize, vertexBuffer, vertexBufferMemory))
+			throw std::runtime_error("failed to upload vertex buffer!");
+		makeBufferMovable(bufferSize, usage, vertexBufferMemory, vertexBuffer, vertexBufferHandle);
+	}
+	//the defragmenter owns the buffer from here on and updates it when it moves
+	void makeBufferMovable(VkDeviceSize size, VkBufferUsageFlags usage, const VulkanCookbook::Allocation& bufferMemory,
+		VkBuffer& buffer, uint32_t& handle) {
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		shareWithDefragmenter(bufferInfo);
 
-		endSingleTimeCommands(commandBuffer);
+		//the scene's cached command buffers bind the old buffer, so the new version records them again
+		auto onMoved = [this, &buffer](uint32_t, const VulkanCookbook::MovableResource& resource) {
+			buffer = resource.Buffer;
+			++sceneVersion;
+		};
+		if (!defragmenter.RegisterBuffer(bufferInfo, buffer, bufferMemory, onMoved, handle))
+			throw std::runtime_error("failed to register a movable buffer!");
 	}
-	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-		
-		VkBufferImageCopy region = {};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = 1;
-
-		region.imageOffset = {0, 0, 0};
-		region.imageExtent = {width, height, 1};
-
-		vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-		endSingleTimeCommands(commandBuffer);
+	//the texture, its mipmaps and the vertex and index data go to the GPU in one submit. Nothing waits
+	//for it: the frames are submitted to the same queue, so they run after it.
+	void submitUploads() {
+		if (!stagingHeap.Record() || !transfers.Submit(uploadTicket))
+			throw std::runtime_error("failed to submit uploads!");
 	}
 	void recreateSwapChain() {
 		int width = 0, height = 0;
@@ -704,204 +585,141 @@ private:
 		}
 		vkDeviceWaitIdle(device);
 
-		cleanupSwapChain();
-
+		//a new surface format would change the render pass; otherwise only the size-dependent parts go
+		VkFormat previousFormat = swapChainImageFormat;
+		commandCache.Clear();
+		destroySwapChain();
 		createSwapChain();
 		createImageViews();
-		createRenderPass();
+		if (swapChainImageFormat == previousFormat) {
+			resizeRenderGraph();
+			return;
+		}
+		renderGraph.Reset();
+		destroyGraphicsPipeline();
+		buildRenderGraph();
 		createGraphicsPipeLine();
-		createColorResources();
-		createDepthResources();
-		createFramebuffers();
-		createCommandBuffers();
 	}
 	void createSyncObjects() {
-		imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+		imageAvailableSemaphores.resize(framePacing.FramesInFlight);
+		renderFinishedSemaphores.resize(framePacing.FramesInFlight);
 
 		VkSemaphoreCreateInfo semaphoreInfo = {};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		VkFenceCreateInfo fenceInfo = {};
-		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
-			if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-				vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-				vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS)
+		for (size_t i = 0; i < framePacing.FramesInFlight; ++i)
+			if (vkCreateSemaphore(device, &semaphoreInfo, logicalDevice.HostCallbacks, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(device, &semaphoreInfo, logicalDevice.HostCallbacks, &renderFinishedSemaphores[i]) != VK_SUCCESS)
 				throw std::runtime_error("failed to create synchornization objects for a frame!");
+		if (!frameTimeline.Create(logicalDevice, framePacing.FramesInFlight, timelineSemaphores))
+			throw std::runtime_error("failed to create frame timeline!");
 	}
-	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-		VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+	//device-local memory the CPU can also write (resizable BAR, integrated GPUs) is filled in place
+	static constexpr VkMemoryPropertyFlags directWriteMemoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanCookbook::MemoryCategory category,
+		VkBuffer& buffer, VulkanCookbook::Allocation& bufferMemory, VkMemoryPropertyFlags preferredProperties = 0, bool movable = false) {
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		bufferInfo.size = size;
 		bufferInfo.usage = usage;
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (movable)
+			shareWithDefragmenter(bufferInfo);
 
-		if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
-			throw std::runtime_error("failed to create vertex buffer!");
-
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-			throw std::runtime_error("failed to allocate vertex buffer memory!");
-		vkBindBufferMemory(device, buffer, bufferMemory, 0);
-	}
-	void createCommandBuffers() {
-		commandBuffers.resize(swapChainFramebuffers.size());
-
-		VkCommandBufferAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.commandPool = commandPool;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = static_cast<uint32_t> (commandBuffers.size());
-
-		if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS)
-			throw std::runtime_error("failed to allcoate command buffers!");
-
-		for (size_t i = 0; i < commandBuffers.size(); ++i) {
-			VkCommandBufferBeginInfo beginInfo = {};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-			beginInfo.pInheritanceInfo = nullptr;
-
-			if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS)
-				throw std::runtime_error("failed to begin recording command buffer!");
-
-			VkRenderPassBeginInfo renderPassInfo = {};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = renderPass;
-			renderPassInfo.framebuffer = swapChainFramebuffers[i];
-			renderPassInfo.renderArea.offset = { 0, 0 };
-			renderPassInfo.renderArea.extent = swapChainExtent;
-
-			std::array<VkClearValue, 2> clearValues = {};
-			clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-			clearValues[1].depthStencil = { 1.0f, 0 };
-			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-			renderPassInfo.pClearValues = clearValues.data();
-			
-			vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-				vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-				VkBuffer vertexBuffers[] = { vertexBuffer };
-				VkDeviceSize offsets[] = { 0 };
-				vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
-				vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-				vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
-					0, 1, &descriptorSets[i], 0, nullptr);
-				vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
-			vkCmdEndRenderPass(commandBuffers[i]);
-			if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
-				throw std::runtime_error("failed to record command buffer!");
-
-		}
-
+		VulkanCookbook::AllocationCreateInfo allocInfo;
+		allocInfo.RequiredFlags = properties;
+		allocInfo.PreferredFlags = preferredProperties;
+		allocInfo.Category = category;
+		if (!allocator->CreateBuffer(bufferInfo, allocInfo, buffer, bufferMemory))
+			throw std::runtime_error("failed to create buffer!");
 	}
-	void createCommandPool() {
-		QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
-
-		VkCommandPoolCreateInfo poolInfo = {};
-		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
-		poolInfo.flags = 0;
-		if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
-			throw std::runtime_error("failed to create command pool!");
-	}
-	void createFramebuffers() {
-		swapChainFramebuffers.resize(swapChainImageViews.size());
-		for (size_t i = 0; i < swapChainImageViews.size(); ++i) {
-			std::array<VkImageView, 3> attachments = { colorImageView, depthImageView, swapChainImageViews[i]};
-
-			VkFramebufferCreateInfo framebufferInfo = {};
-			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			framebufferInfo.renderPass = renderPass;
-			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-			framebufferInfo.pAttachments = attachments.data();
-			framebufferInfo.width = swapChainExtent.width;
-			framebufferInfo.height = swapChainExtent.height;
-			framebufferInfo.layers = 1;
-			if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS)
-				throw std::runtime_error("failed to create framebuffer!");
-		}
+	void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+			throw std::runtime_error("failed to begin recording command buffer!");
+		if (!renderGraph.Execute(commandBuffer, imageIndex))
+			throw std::runtime_error("failed to record render graph!");
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to record command buffer!");
+	}
+	//the variant of the graph is the swapchain image index. Nothing the draws bind changes from frame to
+	//frame, only the uniform data, so each image's secondary command buffers are recorded once and
+	//executed again until a buffer is moved or the swapchain is recreated. Dynamic state is not
+	//inherited, so every slice sets the viewport and scissor of the pass itself.
+	bool recordScene(const VulkanCookbook::PassContext& context) {
+		uint32_t imageIndex = context.Variant;
+		//binds the partition this swapchain image's uniforms were written to
+		uint32_t dynamicOffset = static_cast<uint32_t>(uniformRing.FrameOffset(imageIndex));
+		uint32_t drawCount = static_cast<uint32_t>(meshDraws.size());
+		VkExtent2D extent = context.Extent;
+		uint64_t version = VulkanCookbook::HashCombine(sceneVersion, graphicsPipeline);
+		version = VulkanCookbook::HashCombine(version, pipelineLayout);
+		version = VulkanCookbook::HashCombine(version, vertexBuffer);
+		version = VulkanCookbook::HashCombine(version, indexBuffer);
+		version = VulkanCookbook::HashCombine(version, descriptorSets[imageIndex]);
+		version = VulkanCookbook::HashCombine(version, dynamicOffset);
+		version = VulkanCookbook::HashCombine(version, static_cast<uint64_t>(extent.width) << 32 | extent.height);
+		//the draw list is the model's shapes; every slice binds its own state and draws its range of them,
+		//so a model of a single shape is recorded into a single secondary command buffer
+		auto recordSlice = [this, imageIndex, dynamicOffset, extent](VkCommandBuffer secondary, uint32_t first, uint32_t count) {
+			vkCmdBindPipeline(secondary, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+			VkViewport viewport = { 0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f };
+			VkRect2D scissor = { { 0, 0 }, extent };
+			vkCmdSetViewport(secondary, 0, 1, &viewport);
+			vkCmdSetScissor(secondary, 0, 1, &scissor);
+			VkBuffer vertexBuffers[] = { vertexBuffer };
+			VkDeviceSize offsets[] = { 0 };
+			vkCmdBindVertexBuffers(secondary, 0, 1, vertexBuffers, offsets);
+			vkCmdBindIndexBuffer(secondary, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindDescriptorSets(secondary, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
+				0, 1, &descriptorSets[imageIndex], 1, &dynamicOffset);
+			for (uint32_t draw = first; draw < first + count; ++draw)
+				vkCmdDrawIndexed(secondary, meshDraws[draw].indexCount, 1, meshDraws[draw].firstIndex, 0, 0);
+		};
+		uint64_t key = static_cast<uint64_t>(scenePass) << 32 | imageIndex;
+		return commandCache.Execute(context.CommandBuffer, key, version, context.RenderPass, 0, context.Framebuffer,
+			drawCount, recordSlice);
 	}
-	void createRenderPass() {
-		VkAttachmentDescription colorAttachment = {};
-		colorAttachment.format = swapChainImageFormat;
-		colorAttachment.samples = msaaSamples;
-		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentDescription depthAttachment = {};
-		depthAttachment.format = findDepthFormat();
-		depthAttachment.samples = msaaSamples;
-		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentDescription colorAttachmentResolve = {};
-		colorAttachmentResolve.format = swapChainImageFormat;
-		colorAttachmentResolve.samples = VK_SAMPLE_COUNT_1_BIT;
-		colorAttachmentResolve.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-		
-		VkAttachmentReference colorAttachmentRef = {};
-		colorAttachmentRef.attachment = 0;
-		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentReference depthAttachmentRef = {};
-		depthAttachmentRef.attachment = 1;
-		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-		
-		VkAttachmentReference colorAttachmentResolveRef = {};
-		colorAttachmentResolveRef.attachment = 2;
-		colorAttachmentResolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkSubpassDescription subpass = {};
-		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpass.colorAttachmentCount = 1;
-		subpass.pColorAttachments = &colorAttachmentRef;
-		subpass.pResolveAttachments = &colorAttachmentResolveRef;
-		subpass.pDepthStencilAttachment = &depthAttachmentRef;
-
-		VkSubpassDependency dependency = {};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-		std::array<VkAttachmentDescription, 3> attachments = { colorAttachment, depthAttachment, colorAttachmentResolve };
-		VkRenderPassCreateInfo renderPassInfo = {};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-		renderPassInfo.pAttachments = attachments.data();
-		renderPassInfo.subpassCount = 1;
-		renderPassInfo.pSubpasses = &subpass;
-		renderPassInfo.dependencyCount = 1;
-		renderPassInfo.pDependencies = &dependency;
-
-		if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create render pass!");
+	//one transient pool per frame in flight for the primary command buffers, reset as a whole once the
+	//frame's fence has signalled; the scene's secondaries are recorded on the job threads into the
+	//command cache's own pools
+	void createCommandPool() {
+		uint32_t graphicsFamily = queues.FamilyIndex(VulkanCookbook::QueueWorkload::Graphics);
+		if (!frameCommands.Create(logicalDevice, graphicsFamily, framePacing.FramesInFlight, 1))
+			throw std::runtime_error("failed to create command pools!");
+		if (!parallelRecorder.Create(logicalDevice, jobs))
+			throw std::runtime_error("failed to start command recording threads!");
+		if (!commandCache.Create(logicalDevice, graphicsFamily, parallelRecorder, jobs, frameTimeline))
+			throw std::runtime_error("failed to create command cache!");
+	}
+	//the mipmap blits need a graphics queue, and the buffers go up in the same submit as the texture,
+	//so uploads stay on the graphics queue rather than the planned transfer queue
+	void createStagingHeap() {
+		const VkDeviceSize stagingHeapSize = 64 * 1024 * 1024;
+		if (!transfers.Create(logicalDevice, graphicsQueue, queues.FamilyIndex(VulkanCookbook::QueueWorkload::Graphics)))
+			throw std::runtime_error("failed to create transfer context!");
+		if (!stagingHeap.Create(*allocator, transfers, stagingHeapSize))
+			throw std::runtime_error("failed to create staging heap!");
+	}
+	//the moves are plain copies, so they run on the transfer queue, next to the frames rather than between them
+	void createDefragmenter() {
+		if (!defragmenter.Create(*allocator, queues.Get(VulkanCookbook::QueueWorkload::Transfer),
+								 queues.FamilyIndex(VulkanCookbook::QueueWorkload::Transfer), frameTimeline))
+			throw std::runtime_error("failed to create memory defragmenter!");
+	}
+	//A transfer queue in a family of its own has to share the buffers the defragmenter moves with the
+	//graphics family; concurrent sharing saves an ownership transfer on every move.
+	void shareWithDefragmenter(VkBufferCreateInfo& bufferInfo) {
+		movableQueueFamilies = { queues.FamilyIndex(VulkanCookbook::QueueWorkload::Graphics),
+								 queues.FamilyIndex(VulkanCookbook::QueueWorkload::Transfer) };
+		if (movableQueueFamilies[0] != movableQueueFamilies[1]) {
+			bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(movableQueueFamilies.size());
+			bufferInfo.pQueueFamilyIndices = movableQueueFamilies.data();
 		}
 	}
 	void createGraphicsPipeLine() {
@@ -941,24 +759,19 @@ private:
 		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 		inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)swapChainExtent.width;
-		viewport.height = (float)swapChainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor = {};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swapChainExtent;
-
+		//viewport and scissor are set while recording, so a resize keeps the pipeline
 		VkPipelineViewportStateCreateInfo viewportState = {};
 		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
+		viewportState.pViewports = nullptr;
 		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
+		viewportState.pScissors = nullptr;
+
+		VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+		VkPipelineDynamicStateCreateInfo dynamicState = {};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = 2;
+		dynamicState.pDynamicStates = dynamicStates;
 
 		VkPipelineRasterizationStateCreateInfo rasterizer = {};
 		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -996,7 +809,7 @@ private:
 		pipelineLayoutInfo.setLayoutCount = 1;
 		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
 
-		if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, logicalDevice.HostCallbacks, &pipelineLayout) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create pipeline layout!");
 		}
 
@@ -1024,17 +837,18 @@ private:
 		pipelineInfo.pMultisampleState = &multisampling;
 		pipelineInfo.pColorBlendState = &colorBlending;
 		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pDynamicState = &dynamicState;
 		pipelineInfo.layout = pipelineLayout;
 		pipelineInfo.renderPass = renderPass;
 		pipelineInfo.subpass = 0;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, logicalDevice.HostCallbacks, &graphicsPipeline) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create graphics pipeline!");
 		}
 
-		vkDestroyShaderModule(device, fragShaderModule, nullptr);
-		vkDestroyShaderModule(device, vertShaderModule, nullptr);
+		vkDestroyShaderModule(device, fragShaderModule, logicalDevice.HostCallbacks);
+		vkDestroyShaderModule(device, vertShaderModule, logicalDevice.HostCallbacks);
 	}
 	VkShaderModule createShaderModule(const std::vector<char>&  code) {
 		VkShaderModuleCreateInfo createInfo = {};
@@ -1042,7 +856,7 @@ private:
 		createInfo.codeSize = code.size();
 		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
 		VkShaderModule shaderModule;
-		if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		if (vkCreateShaderModule(device, &createInfo, logicalDevice.HostCallbacks, &shaderModule) != VK_SUCCESS)
 			throw std::runtime_error("failed to create shader module!");
 		return shaderModule;
 	}
@@ -1057,9 +871,8 @@ private:
 		VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
 		VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
 		VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
-		uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
-		if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
-			imageCount = swapChainSupport.capabilities.maxImageCount;
+		uint32_t imageCount;
+		VulkanCookbook::vkapp::selectNumberOfSwapchainImages(swapChainSupport.capabilities, imageCount, framePacing.SwapchainImages);
 		VkSwapchainCreateInfoKHR createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
 		createInfo.surface = surface;
@@ -1071,10 +884,10 @@ private:
 		createInfo.imageArrayLayers = 1;
 		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
-		uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+		uint32_t queueFamilyIndices[] = { queues.FamilyIndex(VulkanCookbook::QueueWorkload::Graphics),
+										  queues.FamilyIndex(VulkanCookbook::QueueWorkload::Present) };
 
-		if (indices.graphicsFamily != indices.presentFamily) {
+		if (queueFamilyIndices[0] != queueFamilyIndices[1]) {
 			createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
 			createInfo.queueFamilyIndexCount = 2;
 			createInfo.pQueueFamilyIndices = queueFamilyIndices;
@@ -1091,7 +904,7 @@ private:
 		createInfo.clipped = VK_TRUE;
 		createInfo.oldSwapchain = VK_NULL_HANDLE;
 
-		if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain) != VK_SUCCESS)
+		if (vkCreateSwapchainKHR(device, &createInfo, logicalDevice.HostCallbacks, &swapChain) != VK_SUCCESS)
 			throw std::runtime_error("failed to create swap chain");
 		vkGetSwapchainImagesKHR(device, swapChain, &imageCount, nullptr);
 		swapChainImages.resize(imageCount);
@@ -1100,96 +913,78 @@ private:
 		swapChainExtent = extent;
 	}
 	void createSurface() {
-		if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
+		if (glfwCreateWindowSurface(instance, window, instanceArena.Callbacks(), &surface) != VK_SUCCESS)
 			throw std::runtime_error("failed to create window surface!");
 	}
+	//Device layers are ignored by every current loader, so the validation layers are only enabled on the
+	//instance. The planner puts transfers on a transfer-only family when there is one.
 	void createLogicalDevice() {
-		QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
-
-		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
-		float queuePriority = 1.0f;
-		for (uint32_t queueFamily : uniqueQueueFamilies) {
-			VkDeviceQueueCreateInfo queueCreateInfo = {};
-			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-			queueCreateInfo.queueFamilyIndex = queueFamily;
-			queueCreateInfo.queueCount = 1;
-			queueCreateInfo.pQueuePriorities = &queuePriority;
-			queueCreateInfos.push_back(queueCreateInfo);
-		}
+		VulkanCookbook::QueuePlan plan;
+		uint32_t workloads = VulkanCookbook::WorkloadBit(VulkanCookbook::QueueWorkload::Graphics) |
+							 VulkanCookbook::WorkloadBit(VulkanCookbook::QueueWorkload::Present) |
+							 VulkanCookbook::WorkloadBit(VulkanCookbook::QueueWorkload::Transfer);
+		if (!VulkanCookbook::vkapp::planQueues(physicalDevice, surface, workloads, plan))
+			throw std::runtime_error("failed to plan device queues!");
 
-		VkDeviceQueueCreateInfo queueCreateInfo = {};
 		VkPhysicalDeviceFeatures deviceFeatures = {};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
 		deviceFeatures.sampleRateShading = VK_TRUE;
-		VkDeviceCreateInfo createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
-		createInfo.pQueueCreateInfos = queueCreateInfos.data();
-		createInfo.pEnabledFeatures = &deviceFeatures;
-
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
-		if (enableValidationLayers) {
-			createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
-			createInfo.ppEnabledLayerNames = validationLayers.data();
+		const void* featureChain = nullptr;
+
+		std::vector<const char*> enabledExtensions = deviceExtensions;
+	#ifdef VK_EXT_memory_budget
+		if (physicalDeviceInfo->Extensions().Contains(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+			enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	#endif
+	#ifdef VK_KHR_timeline_semaphore
+		//every device with the extension supports the feature, so it is not queried
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+		timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+		timelineFeatures.timelineSemaphore = VK_TRUE;
+		timelineSemaphores = physicalDeviceInfo->Extensions().Contains(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+		if (timelineSemaphores) {
+			enabledExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+			featureChain = &timelineFeatures;
 		}
-		else
-			createInfo.enabledLayerCount = 0;
-		if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS)
+	#endif
+		if (!VulkanCookbook::vkapp::createLogicalDeviceWithQueuePlan(physicalDevice, plan, enabledExtensions, &deviceFeatures,
+																	 logicalDevice, queues, featureChain))
 			throw std::runtime_error("failed to create logical device!");
-		vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
-		vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &presentQueue);
-	}
-	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-		VkPhysicalDeviceMemoryProperties memProperties;
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-
-		for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-			if (typeFilter & (1 << i) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-				return i;
-		throw std::runtime_error("failed to find suitable memory type!");
-	}
-	VkCommandBuffer beginSingleTimeCommands() {
-		VkCommandBufferAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = commandPool;
-		allocInfo.commandBufferCount = 1;
-
-		VkCommandBuffer commandBuffer;
-		vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-		vkBeginCommandBuffer(commandBuffer, &beginInfo);
-		return commandBuffer;
-	}
-	void endSingleTimeCommands(VkCommandBuffer commandBuffer) {
-		vkEndCommandBuffer(commandBuffer);
-
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-
-		vkQueueSubmit(graphicsQueue, 1, &submitInfo, nullptr);
-		vkQueueWaitIdle(graphicsQueue);
-
-		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+		device = logicalDevice.Handle;
+		if (!VulkanCookbook::vkapp::loadDeviceLevelFunctions(device, enabledExtensions))
+			throw std::runtime_error("failed to load device-level functions!");
+		VulkanCookbook::vkapp::reportFunctionLoadingTimings();
+		allocator = std::make_unique<VulkanCookbook::DeviceMemoryAllocator>(logicalDevice, *physicalDeviceInfo);
+		transientAttachments.Create(*allocator);
+		resourceStates.Create(logicalDevice);
+		renderGraph.Create(logicalDevice, transientAttachments, resourceStates);
+		graphicsQueue = queues.Get(VulkanCookbook::QueueWorkload::Graphics);
+		presentQueue = queues.Get(VulkanCookbook::QueueWorkload::Present);
+	}
+	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties = 0,
+		VkMemoryPropertyFlags avoidedProperties = 0) {
+		VulkanCookbook::MemoryTypePreference preference;
+		preference.Required = properties;
+		preference.Preferred = preferredProperties;
+		preference.Avoided = avoidedProperties;
+		uint32_t memoryTypeIndex;
+		if (!physicalDeviceInfo->FindMemoryType(typeFilter, preference, memoryTypeIndex))
+			throw std::runtime_error("failed to find suitable memory type!");
+		return memoryTypeIndex;
 	}
 	void pickPhysicalDevice() {
-		uint32_t deviceCount = 0;
-		vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
-		if (deviceCount == 0)
+		VulkanCookbook::DeviceRequirements requirements;
+		requirements.RequiredFeatures.samplerAnisotropy = VK_TRUE;
+		requirements.OptionalFeatures.sampleRateShading = VK_TRUE;
+		requirements.RequiredExtensions = deviceExtensions;
+		std::vector<VulkanCookbook::DeviceScore> ranking;
+		if (!VulkanCookbook::vkapp::rankPhysicalDevices(instance, VulkanCookbook::DefaultDeviceRankingPolicy(requirements), ranking))
 			throw std::runtime_error("failed to find GPUs with Vulkan support!");
-		std::vector<VkPhysicalDevice> devices(deviceCount);
-		vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
-		for (const auto& device : devices)
-			if (isDeviceSuitable(device)) {
-				physicalDevice = device;
+		//surface support depends on the window, so it is checked on the ranked candidates rather than scored
+		for (const auto& score : ranking)
+			if (score.Suitable && isDeviceSuitable(score.Device->Handle())) {
+				physicalDevice = score.Device->Handle();
+				physicalDeviceInfo = score.Device;
 				msaaSamples = getMaxUsableSampleCount();
 				break;
 			}
@@ -1197,6 +992,9 @@ private:
 			throw std::runtime_error("failed to find a suitable GPU!");
 	}
 	bool isDeviceSuitable(VkPhysicalDevice device) {
+		const VulkanCookbook::PhysicalDeviceInfo* deviceInfo = VulkanCookbook::vkapp::getPhysicalDeviceInfo(device);
+		if (!deviceInfo)
+			return false;
 		bool swapChainAdequate = false;
 		bool extensionsSupported = checkDeviceExtensionsSupport(device);
 		if (extensionsSupported) {
@@ -1204,23 +1002,15 @@ private:
 			swapChainAdequate = !(swapChainSupport.formats.empty() && swapChainSupport.presentModes.empty());
 		}
 
-		VkPhysicalDeviceFeatures supportedFeatures;
-		vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
-		return findQueueFamilies(device).isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+		return findQueueFamilies(device).isComplete() && extensionsSupported && swapChainAdequate && 
+			   deviceInfo->Features().samplerAnisotropy;
 	}
 	bool checkDeviceExtensionsSupport(VkPhysicalDevice device) {
-		uint32_t extensionCount;
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
-
-		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
-
-		std::set <std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
-
-		for (const auto& extension : availableExtensions)
-			requiredExtensions.erase(extension.extensionName);
-
-		return requiredExtensions.empty();
+		const VulkanCookbook::ExtensionSet& availableExtensions = VulkanCookbook::vkapp::getPhysicalDeviceInfo(device)->Extensions();
+		for (const char* extension : deviceExtensions)
+			if (!availableExtensions.Contains(extension))
+				return false;
+		return true;
 	}
 	VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
 		if (availableFormats.size() == 1 && availableFormats[0].format == VK_FORMAT_UNDEFINED)
@@ -1265,10 +1055,12 @@ private:
 		createInfo.pfnUserCallback = debugCallback;
 		createInfo.pUserData = nullptr;
 
-		if (CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &callback) != VK_SUCCESS)
+		if (CreateDebugUtilsMessengerEXT(instance, &createInfo, instanceArena.Callbacks(), &callback) != VK_SUCCESS)
 			throw std::runtime_error("failed  to set up debug callback");
 	}
 	void createInstance() {
+		if (!VulkanCookbook::vkapp::loadVulkanLibrary(vulkanLibrary))
+			throw std::runtime_error("failed to load the Vulkan loader!");
 		if (enableValidationLayers && !checkValidationLayerSupport())
 			throw std::runtime_error("validation layers requested, but not available");
 
@@ -1295,18 +1087,39 @@ private:
 		else
 			createInfo.enabledLayerCount = 0;
 
-		if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS)
+		//also loads what device selection and the allocator's heap budgets call
+		if (!VulkanCookbook::vkapp::createVulkanInstance(createInfo, instanceArena.Callbacks(), vulkanInstance))
 			throw std::runtime_error("failed to create instance!");
+		instance = vulkanInstance.Handle;
 	}
 	void mainLoop() {
 		while (!glfwWindowShouldClose(window)) {
-			glfwPollEvents();
+			if (!framePacing.JustInTimeInput)
+				glfwPollEvents();
 			drawFrame();
 		}
 		vkDeviceWaitIdle(device);
+		const VulkanCookbook::FrameTimelineStats& pacingStats = frameTimeline.Stats();
+		std::cout << "submit to complete: " << pacingStats.AverageSubmitToComplete.count() << " ms average, "
+				  << pacingStats.MaxSubmitToComplete.count() << " ms max over " << pacingStats.MeasuredFrames << " frame(s)" << std::endl;
+		VulkanCookbook::CommandCacheStats cacheStats = commandCache.Stats();
+		std::cout << "command cache: " << cacheStats.Hits << " hit(s), " << cacheStats.Misses << " recording(s) in "
+				  << cacheStats.AllocatedBuffers << " command buffer(s)" << std::endl;
+		std::ofstream memoryStats("memory_stats.json");
+		allocator->WriteStatsJson(memoryStats);
+		instanceArena.PrintStats();
+		VulkanCookbook::vkapp::deviceHostArena.PrintStats();
 	}
 	void drawFrame() {
-		vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits <uint64_t>::max());
+		if (!frameTimeline.BeginFrame())
+			throw std::runtime_error("failed to wait for frame!");
+		uint32_t currentFrame = frameTimeline.FrameIndex();
+		allocator->UpdateBudget();
+		//the moves copy on another queue, so nothing moves before the first uploads are in place
+		if (transfers.IsComplete(uploadTicket) && !defragmenter.Step())
+			throw std::runtime_error("failed to defragment device memory!");
+		if (!frameCommands.BeginFrame(currentFrame))
+			throw std::runtime_error("failed to reset command pool!");
 
 		uint32_t imageIndex;
 		VkResult result = vkAcquireNextImageKHR(device, swapChain, std::numeric_limits<uint64_t>::max(),
@@ -1319,7 +1132,18 @@ private:
 		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
 			throw std::runtime_error("failed to acquire swap chain image!");
 		
+		//the acquire may have blocked; waiting for the GPU only now and sampling input afterwards keeps
+		//the frame from carrying input that is older than the queue ahead of it
+		if (framePacing.JustInTimeInput) {
+			if (!frameTimeline.Wait(frameTimeline.CurrentFrame() - 1))
+				throw std::runtime_error("failed to wait for frame!");
+			glfwPollEvents();
+		}
 		updateUniformBuffer(imageIndex);
+		VkCommandBuffer commandBuffer = frameCommands.Acquire(0);
+		if (!commandBuffer)
+			throw std::runtime_error("failed to allocate command buffer!");
+		recordCommandBuffer(commandBuffer, imageIndex);
 
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -1330,14 +1154,13 @@ private:
 		submitInfo.pWaitDstStageMask = waitStages;
 
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+		submitInfo.pCommandBuffers = &commandBuffer;
 
 		VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = signalSemaphores;
-		vkResetFences(device, 1, &inFlightFences[currentFrame]);
 
-		if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+		if (!frameTimeline.Submit(graphicsQueue, submitInfo))
 			throw std::runtime_error("failed to submit draw command buffer!");
 
 		VkPresentInfoKHR presentInfo = {};
@@ -1358,8 +1181,6 @@ private:
 		}
 		else if (result != VK_SUCCESS)
 			throw std::runtime_error("failed to present swap chain image!");
-
-		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 	}
 	void updateUniformBuffer(uint32_t currentImage){
 		static auto startTime = std::chrono::high_resolution_clock::now();
@@ -1373,10 +1194,11 @@ private:
 		ubo.proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float)swapChainExtent.height, 0.1f, 10.0f);
 		ubo.proj[1][1] *= -1;
 
-		void* data;
-		vkMapMemory(device, uniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
-			memcpy(data, &ubo, sizeof(ubo));
-		vkUnmapMemory(device, uniformBuffersMemory[currentImage]);
+		uniformRing.BeginFrame(currentImage);
+		uint32_t dynamicOffset;
+		if (!uniformRing.Push(ubo, dynamicOffset))
+			throw std::runtime_error("failed to write uniform buffer!");
+		uniformRing.EndFrame();
 	} 
 	SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device) {
 		SwapChainSupportDetails details;
@@ -1412,62 +1234,62 @@ private:
 		return false;
 	}
 	void cleanupSwapChain() {
-		vkDestroyImageView(device, colorImageView, nullptr);
-		vkDestroyImage(device, colorImage, nullptr);
-		vkFreeMemory(device, colorImageMemory, nullptr);
-
-		for (auto framebuffer : swapChainFramebuffers)
-			vkDestroyFramebuffer(device, framebuffer, nullptr);
-		vkFreeCommandBuffers(device, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
-		vkDestroyPipeline(device, graphicsPipeline, nullptr);;
-		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
-		vkDestroyRenderPass(device, renderPass, nullptr);
+		//the cached recordings continue render passes and bind a pipeline that are about to go
+		commandCache.Clear();
+		renderGraph.Reset();
+		destroyGraphicsPipeline();
+		destroySwapChain();
+	}
+	void destroyGraphicsPipeline() {
+		vkDestroyPipeline(device, graphicsPipeline, logicalDevice.HostCallbacks);
+		vkDestroyPipelineLayout(device, pipelineLayout, logicalDevice.HostCallbacks);
+	}
+	void destroySwapChain() {
 		for (auto imageView : swapChainImageViews)
-			vkDestroyImageView(device, imageView, nullptr);
-		vkDestroySwapchainKHR(device, swapChain, nullptr);
+			vkDestroyImageView(device, imageView, logicalDevice.HostCallbacks);
+		vkDestroySwapchainKHR(device, swapChain, logicalDevice.HostCallbacks);
 	}
 	void cleanup() {
 		cleanupSwapChain();
 
-		vkDestroySampler(device, textureSampler, nullptr);
-		vkDestroyImageView(device, textureImageView, nullptr);
-
-		vkDestroyImageView(device, depthImageView, nullptr);
-		vkDestroyImage(device, depthImage, nullptr);
-		vkFreeMemory(device, depthImageMemory, nullptr);
-		
-		vkDestroyImage(device, textureImage, nullptr);
-		vkFreeMemory(device, textureImageMemory, nullptr);
+		vkDestroySampler(device, textureSampler, logicalDevice.HostCallbacks);
+		vkDestroyImageView(device, textureImageView, logicalDevice.HostCallbacks);
 
-		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
-		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+		resourceStates.ForgetImage(textureImage);
+		allocator->DestroyImage(textureImage, textureImageMemory);
 
-		for (size_t i = 0; i < swapChainImages.size(); ++i) {
-			vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-			vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
-		}
+		vkDestroyDescriptorPool(device, descriptorPool, logicalDevice.HostCallbacks);
+		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, logicalDevice.HostCallbacks);
 
-		vkDestroyBuffer(device, indexBuffer, nullptr);
-		vkFreeMemory(device, indexBufferMemory, nullptr);
+		uniformRing.Destroy();
 
-		vkDestroyBuffer(device, vertexBuffer, nullptr);
-		vkFreeMemory(device, vertexBufferMemory, nullptr);
+		defragmenter.Destroy();
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-			vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
-			vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
-			vkDestroyFence(device, inFlightFences[i], nullptr);
+		for (size_t i = 0; i < framePacing.FramesInFlight; ++i) {
+			vkDestroySemaphore(device, renderFinishedSemaphores[i], logicalDevice.HostCallbacks);
+			vkDestroySemaphore(device, imageAvailableSemaphores[i], logicalDevice.HostCallbacks);
 		}
+		frameTimeline.Destroy();
 		
-		vkDestroyCommandPool(device, commandPool, nullptr);
+		commandCache.Destroy();
+		parallelRecorder.Destroy();
+		frameCommands.Destroy();
+		jobs.Destroy();
 		
-		vkDestroyDevice(device, nullptr);
+		stagingHeap.Destroy();
+		transfers.Destroy();
+		renderGraph.Destroy();
+		resourceStates.Destroy();
+		transientAttachments.Destroy();
+		allocator.reset();
+		VulkanCookbook::vkapp::destroyLogicalDevice(logicalDevice);
 		
 		if (enableValidationLayers)
-			DestroyDebugUtilsMessengerEXT(instance, callback, nullptr);
+			DestroyDebugUtilsMessengerEXT(instance, callback, instanceArena.Callbacks());
 		
-		vkDestroySurfaceKHR(instance, surface, nullptr);
-		vkDestroyInstance(instance, nullptr);
+		vulkanInstance.Dispatch.vkDestroySurfaceKHR(instance, surface, vulkanInstance.HostCallbacks);
+		VulkanCookbook::vkapp::destroyInstance(vulkanInstance);
+		VulkanCookbook::vkapp::releaseVulkanLoaderLibrary(vulkanLibrary);
 		
 		glfwDestroyWindow(window);
 		
@@ -1489,16 +1311,13 @@ private:
 		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
 		if (enableValidationLayers)
 			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
 		return extensions;
 	}
 	QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) {
 		QueueFamilyIndices indices;
 
-		uint32_t queueFamilyCount = 0;
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
-
-		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+		const std::vector<VkQueueFamilyProperties>& queueFamilies = VulkanCookbook::vkapp::getPhysicalDeviceInfo(device)->QueueFamilies();
 		int i = 0;
 		for (const auto& queueFamily : queueFamilies) {
 			VkBool32 presentSupport = false;
@@ -1544,16 +1363,18 @@ private:
 #pragma region Member Variables
 	const int WIDTH = 800;
 	const int HEIGHT = 600;
-	const int MAX_FRAMES_IN_FLIGHT = 2;
+	const uint32_t MAX_JOB_THREADS = 8;
 	const std::string MODEL_PATH = "chalet.obj";
 	const std::string TEXTURE_PATH = "chalet.jpg";
-	size_t currentFrame = 0;
 	std::vector<VkSemaphore> imageAvailableSemaphores;
 	std::vector<VkSemaphore> renderFinishedSemaphores;
-	std::vector<VkFence> inFlightFences;
+	VulkanCookbook::FramePacing framePacing;
+	VulkanCookbook::FrameTimeline frameTimeline;
+	bool timelineSemaphores = false;
 	
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
+	std::vector<MeshDraw> meshDraws;
 
 	bool framebufferResized = false;
 
@@ -1564,53 +1385,72 @@ private:
 
 	GLFWwindow* window;
 
+	//declared first so that it outlives every object created with it; the device's is vkapp::deviceHostArena
+	VulkanCookbook::HostArena instanceArena{ "Instance" };
+	LIBRARY_TYPE vulkanLibrary = nullptr;
+	VulkanCookbook::VulkanInstance vulkanInstance;
 	VkInstance instance;
 	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	const VulkanCookbook::PhysicalDeviceInfo* physicalDeviceInfo = nullptr;
 	VkDebugUtilsMessengerEXT callback;
 	VkDevice device;
-	
-	VkImage colorImage;
-	VkDeviceMemory colorImageMemory;
-	VkImageView colorImageView;
+	VulkanCookbook::LogicalDevice logicalDevice;
+	std::unique_ptr<VulkanCookbook::DeviceMemoryAllocator> allocator;
+	VulkanCookbook::TransferContext transfers;
+	VulkanCookbook::ResourceStateTracker resourceStates;
+	uint64_t uploadTicket = 0;
+	VulkanCookbook::Milliseconds initTime{};
+	VulkanCookbook::StagingHeap stagingHeap;
+	VulkanCookbook::MemoryDefragmenter defragmenter;
+	VulkanCookbook::TransientImagePool transientAttachments;
+	VulkanCookbook::RenderGraph renderGraph;
+	VulkanCookbook::GraphPass scenePass;
+	VulkanCookbook::GraphResource sceneColor;
+	VulkanCookbook::GraphResource sceneDepth;
+	VulkanCookbook::GraphResource backbuffer;
 
 	uint32_t mipLevels;
 	VkImage textureImage;
 	VkImageView textureImageView;
 	VkSampler textureSampler;
-	VkDeviceMemory textureImageMemory;
-
-	VkImage depthImage;
-	VkDeviceMemory depthImageMemory;
-	VkImageView depthImageView;
+	VulkanCookbook::Allocation textureImageMemory;
 
+	VulkanCookbook::QueueMap queues;
+	std::array<uint32_t, 2> movableQueueFamilies;
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
 	VkSurfaceKHR surface;
 	
 	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
+	uint32_t vertexBufferHandle;
 	VkBuffer indexBuffer;
-	VkDeviceMemory indexBufferMemory;
+	uint32_t indexBufferHandle;
 
 	VkDescriptorPool descriptorPool;
 	std::vector<VkDescriptorSet> descriptorSets;
-	std::vector<VkBuffer> uniformBuffers;
-	std::vector<VkDeviceMemory> uniformBuffersMemory;
+	VulkanCookbook::UniformRingBuffer uniformRing;
 
 	std::vector<VkImage> swapChainImages;
 	std::vector<VkImageView> swapChainImageViews;
-	std::vector<VkFramebuffer> swapChainFramebuffers;
-	std::vector<VkCommandBuffer> commandBuffers;
 	VkFormat swapChainImageFormat;
 	VkExtent2D swapChainExtent;
 	VkSwapchainKHR swapChain;
 
 	VkPipelineLayout pipelineLayout;
 	VkDescriptorSetLayout descriptorSetLayout;
-	VkRenderPass renderPass;
+	VkRenderPass renderPass;	//of the scene pass, owned by the graph
 	VkPipeline graphicsPipeline;
 
-	VkCommandPool commandPool;
+	VulkanCookbook::JobSystem jobs;
+	VulkanCookbook::JobCounter assetsLoaded;
+	std::string modelError;
+	stbi_uc* texturePixels = nullptr;
+	int textureWidth = 0;
+	int textureHeight = 0;
+	VulkanCookbook::FrameCommandPools frameCommands;
+	VulkanCookbook::ParallelCommandRecorder parallelRecorder;
+	VulkanCookbook::CommandCache commandCache;
+	uint64_t sceneVersion = 0;	//counts moves of the buffers the scene binds
 
 	VkSemaphore imageAvailableSemaphore;
 	VkSemaphore renderFinishedSemaphore;
@@ -1623,5 +1463,13 @@ private:
 };
 
 
-int main()
-*/
\ No newline at end of file
+int main() {
+	HelloTriangleApplication app;
+	try {
+		app.run();
+	} catch (const std::exception& error) {
+		std::cerr << error.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
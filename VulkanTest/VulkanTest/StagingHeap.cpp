@@ -0,0 +1,255 @@
+#include "StagingHeap.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	namespace {
+		VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	bool StagingHeap::Create(DeviceMemoryAllocator& allocator, TransferContext& transfers, VkDeviceSize capacity) {
+		auto& limits = allocator.DeviceInfo().Limits();
+		NonCoherentAtom = std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1);
+		Capacity = AlignUp(capacity, NonCoherentAtom);
+
+		VkBufferCreateInfo bufferInfo = {
+			VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,	//sType
+			nullptr,								//pNext
+			0,										//flags
+			Capacity,								//size
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,		//usage
+			VK_SHARING_MODE_EXCLUSIVE,				//sharingMode
+			0,										//queueFamilyIndexCount
+			nullptr									//pQueueFamilyIndices
+		};
+		AllocationCreateInfo allocationInfo;
+		allocationInfo.RequiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		allocationInfo.PreferredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		//leave the small host-visible device-local heap to resources that are written in place
+		allocationInfo.AvoidedFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		allocationInfo.Category = MemoryCategory::Staging;
+		if (!allocator.CreateBuffer(bufferInfo, allocationInfo, RingBuffer, Memory))
+			return false;
+
+		Allocator = &allocator;
+		Transfers = &transfers;
+		Coherent = allocator.DeviceInfo().MemoryProperties().memoryTypes[Memory.MemoryTypeIndex].propertyFlags &
+				   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		//16 covers the largest texel block copied from a buffer; atom alignment keeps flushed ranges disjoint
+		OffsetAlignment = std::max<VkDeviceSize>({ 16, limits.optimalBufferCopyOffsetAlignment, Coherent ? 1 : NonCoherentAtom });
+		Head = Tail = 0;
+		return true;
+	}
+
+	void StagingHeap::Destroy() {
+		if (!Allocator)
+			return;
+		//copies recorded but not yet submitted are submitted here, so that the ring is not freed under them
+		uint64_t ticket;
+		if (!InFlight.empty() && Transfers->Submit(ticket))
+			Transfers->Wait(InFlight.back().Ticket);
+		InFlight.clear();
+		Allocator->DestroyBuffer(RingBuffer, Memory);
+		PendingBufferCopies.clear();
+		PendingImageCopies.clear();
+		PendingImageBarriers.clear();
+		PendingFlushRanges.clear();
+		Allocator = nullptr;
+		Transfers = nullptr;
+	}
+
+	bool StagingHeap::TryAllocate(VkDeviceSize size, VkDeviceSize& offset) {
+		if (InFlight.empty() && !HasPending())
+			Head = Tail = 0;
+		VkDeviceSize aligned = AlignUp(Head, OffsetAlignment);
+		//Head == Tail only ever means empty, so the ring is never filled up to Tail exactly
+		if (Head >= Tail) {
+			if (aligned + size <= Capacity) {
+				offset = aligned;
+				Head = aligned + size;
+				return true;
+			}
+			if (size < Tail) {
+				offset = 0;
+				Head = size;
+				return true;
+			}
+			return false;
+		}
+		if (aligned + size < Tail) {
+			offset = aligned;
+			Head = aligned + size;
+			return true;
+		}
+		return false;
+	}
+
+	bool StagingHeap::Allocate(VkDeviceSize size, VkDeviceSize& offset) {
+		if (TryAllocate(size, offset))
+			return true;
+		Reclaim();
+		if (TryAllocate(size, offset))
+			return true;
+		if (!Flush())
+			return false;
+		while (!InFlight.empty()) {
+			if (!Transfers->Wait(InFlight.front().Ticket))
+				return false;
+			Reclaim();
+			if (TryAllocate(size, offset))
+				return true;
+		}
+		return TryAllocate(size, offset);
+	}
+
+	void StagingHeap::Reclaim() {
+		while (!InFlight.empty() && Transfers->IsComplete(InFlight.front().Ticket)) {
+			Tail = InFlight.front().End;
+			InFlight.pop_front();
+		}
+	}
+
+	void StagingHeap::Write(const void* data, VkDeviceSize size, VkDeviceSize offset) {
+		memcpy(static_cast<char*>(Memory.Mapped) + offset, data, static_cast<size_t>(size));
+		if (Coherent)
+			return;
+		VkDeviceSize begin = (Memory.Offset + offset) / NonCoherentAtom * NonCoherentAtom;
+		VkDeviceSize end = AlignUp(Memory.Offset + offset + size, NonCoherentAtom);
+		PendingFlushRanges.push_back({
+			VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,	//sType
+			nullptr,								//pNext
+			Memory.Memory,							//memory
+			begin,									//offset
+			end - begin								//size
+		});
+	}
+
+	bool StagingHeap::UploadToBuffer(const void* data, VkDeviceSize size, VkBuffer buffer, const Allocation& destination,
+									 VkDeviceSize bufferOffset) {
+		if (destination.Mapped)
+			return Allocator->Write(destination, data, size, bufferOffset);
+		return UploadToBuffer(data, size, buffer, bufferOffset);
+	}
+
+	bool StagingHeap::UploadToBuffer(const void* data, VkDeviceSize size, VkBuffer buffer, VkDeviceSize bufferOffset) {
+		//large uploads go through in pieces so that one never needs the whole ring
+		const VkDeviceSize maxChunk = Capacity / 2;
+		const char* bytes = static_cast<const char*>(data);
+		while (size > 0) {
+			VkDeviceSize chunk = std::min(size, maxChunk), offset;
+			if (!Allocate(chunk, offset))
+				return false;
+			Write(bytes, chunk, offset);
+			PendingBufferCopies.push_back({ buffer, { offset, bufferOffset, chunk } });
+			bytes += chunk;
+			bufferOffset += chunk;
+			size -= chunk;
+		}
+		return true;
+	}
+
+	bool StagingHeap::UploadToImage(const void* data, VkDeviceSize size, VkImage image, VkBufferImageCopy region,
+									const VkImageSubresourceRange& subresourceRange) {
+		if (size == 0)
+			return true;
+		if (size + OffsetAlignment > Capacity) {
+			std::cout << "Image upload of " << size << " bytes does not fit the staging heap." << std::endl;
+			return false;
+		}
+		VkDeviceSize offset;
+		if (!Allocate(size, offset))
+			return false;
+		Write(data, size, offset);
+		region.bufferOffset = offset;
+		PendingImageCopies.push_back({ image, region });
+
+		bool transitioned = std::any_of(PendingImageBarriers.begin(), PendingImageBarriers.end(), [&](const VkImageMemoryBarrier& barrier) {
+			return barrier.image == image && barrier.subresourceRange.baseMipLevel == subresourceRange.baseMipLevel &&
+				   barrier.subresourceRange.levelCount == subresourceRange.levelCount &&
+				   barrier.subresourceRange.baseArrayLayer == subresourceRange.baseArrayLayer &&
+				   barrier.subresourceRange.layerCount == subresourceRange.layerCount;
+		});
+		if (!transitioned)
+			PendingImageBarriers.push_back({
+				VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,	//sType
+				nullptr,								//pNext
+				0,										//srcAccessMask
+				VK_ACCESS_TRANSFER_WRITE_BIT,			//dstAccessMask
+				VK_IMAGE_LAYOUT_UNDEFINED,				//oldLayout
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,	//newLayout
+				VK_QUEUE_FAMILY_IGNORED,				//srcQueueFamilyIndex
+				VK_QUEUE_FAMILY_IGNORED,				//dstQueueFamilyIndex
+				image,									//image
+				subresourceRange						//subresourceRange
+			});
+		return true;
+	}
+
+	bool StagingHeap::Record() {
+		if (!HasPending())
+			return true;
+		auto& device = Allocator->Device();
+		auto& dispatch = device.Dispatch;
+		VkCommandBuffer commandBuffer = Transfers->Commands();
+		if (!commandBuffer)
+			return false;
+		if (!PendingFlushRanges.empty())
+			dispatch.vkFlushMappedMemoryRanges(device.Handle, static_cast<uint32_t>(PendingFlushRanges.size()), PendingFlushRanges.data());
+
+		if (!PendingImageBarriers.empty())
+			dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+										  0, nullptr, 0, nullptr,
+										  static_cast<uint32_t>(PendingImageBarriers.size()), PendingImageBarriers.data());
+
+		//one vkCmdCopyBuffer per destination buffer
+		std::stable_sort(PendingBufferCopies.begin(), PendingBufferCopies.end(), [](const BufferCopy& a, const BufferCopy& b) {
+			return a.Buffer < b.Buffer;
+		});
+		std::vector<VkBufferCopy> regions;
+		for (size_t first = 0; first < PendingBufferCopies.size();) {
+			regions.clear();
+			size_t last = first;
+			for (; last < PendingBufferCopies.size() && PendingBufferCopies[last].Buffer == PendingBufferCopies[first].Buffer; ++last)
+				regions.push_back(PendingBufferCopies[last].Region);
+			dispatch.vkCmdCopyBuffer(commandBuffer, RingBuffer, PendingBufferCopies[first].Buffer,
+									 static_cast<uint32_t>(regions.size()), regions.data());
+			first = last;
+		}
+		for (auto& copy : PendingImageCopies)
+			dispatch.vkCmdCopyBufferToImage(commandBuffer, RingBuffer, copy.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy.Region);
+
+		VkMemoryBarrier visibility = {
+			VK_STRUCTURE_TYPE_MEMORY_BARRIER,						//sType
+			nullptr,												//pNext
+			VK_ACCESS_TRANSFER_WRITE_BIT,							//srcAccessMask
+			VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT	//dstAccessMask
+		};
+		dispatch.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+									  1, &visibility, 0, nullptr, 0, nullptr);
+		PendingBufferCopies.clear();
+		PendingImageCopies.clear();
+		PendingImageBarriers.clear();
+		PendingFlushRanges.clear();
+		//a later Record into the same batch moves End forward instead of adding a batch
+		uint64_t ticket = Transfers->PendingTicket();
+		if (!InFlight.empty() && InFlight.back().Ticket == ticket)
+			InFlight.back().End = Head;
+		else
+			InFlight.push_back({ ticket, Head });
+		return true;
+	}
+
+	bool StagingHeap::Flush() {
+		uint64_t ticket;
+		return Record() && Transfers->Submit(ticket);
+	}
+
+	bool StagingHeap::WaitIdle() {
+		if (!Flush())
+			return false;
+		if (!InFlight.empty() && !Transfers->Wait(InFlight.back().Ticket))
+			return false;
+		Reclaim();
+		return true;
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "MemoryAllocator.h"
+#include "TransferContext.h"
+#include <deque>
+namespace VulkanCookbook {
+	//Long-lived ring of persistently mapped host-visible memory for uploads. Upload* copies the data
+	//into the ring right away and queues the GPU copy; Record adds every queued copy to the transfer
+	//context's current batch, and ring space is reclaimed once that batch's ticket completes.
+	//When the ring is full, queued copies are submitted and the oldest ticket is waited for.
+	//Copies run on the transfer context's queue. A destination with exclusive sharing must be used from
+	//the same queue family afterwards, unless the caller transfers its ownership.
+	class StagingHeap {
+	 public:
+		//The transfer context must outlive the heap.
+		bool Create(DeviceMemoryAllocator& allocator, TransferContext& transfers, VkDeviceSize capacity);
+		void Destroy();
+
+		bool UploadToBuffer(const void* data, VkDeviceSize size, VkBuffer buffer, VkDeviceSize bufferOffset = 0);
+		//Writes straight into the destination when its memory is mapped (host-visible device-local memory),
+		//skipping the copy. The GPU must not be using the destination range at that point.
+		bool UploadToBuffer(const void* data, VkDeviceSize size, VkBuffer buffer, const Allocation& destination,
+							VkDeviceSize bufferOffset = 0);
+		//Region's bufferOffset is filled in. The image is moved from UNDEFINED (its contents are discarded)
+		//to TRANSFER_DST_OPTIMAL for subresourceRange before the copy and left in that layout.
+		bool UploadToImage(const void* data, VkDeviceSize size, VkImage image, VkBufferImageCopy region,
+						   const VkImageSubresourceRange& subresourceRange);
+
+		//Records the queued copies into the transfer context's current batch; their writes are made
+		//visible to every command recorded after them and to every later submit on the queue.
+		bool Record();
+		//Records the queued copies and submits the transfer context's batch.
+		bool Flush();
+		//Flushes and blocks until every copy has finished.
+		bool WaitIdle();
+		//Returns the space of batches whose ticket has completed.
+		void Reclaim();
+	 private:
+		struct Batch {
+			uint64_t	 Ticket;
+			VkDeviceSize End;	//ring position after the batch's last upload
+		};
+		struct BufferCopy {
+			VkBuffer	 Buffer;
+			VkBufferCopy Region;
+		};
+		struct ImageCopy {
+			VkImage			  Image;
+			VkBufferImageCopy Region;
+		};
+
+		bool Allocate(VkDeviceSize size, VkDeviceSize& offset);
+		bool TryAllocate(VkDeviceSize size, VkDeviceSize& offset);
+		void Write(const void* data, VkDeviceSize size, VkDeviceSize offset);
+		bool HasPending() const { return !PendingBufferCopies.empty() || !PendingImageCopies.empty(); }
+
+		DeviceMemoryAllocator*			   Allocator		= nullptr;
+		TransferContext*				   Transfers		= nullptr;
+		VkBuffer						   RingBuffer		= VK_NULL_HANDLE;
+		Allocation						   Memory;
+		VkDeviceSize					   Capacity			= 0;
+		VkDeviceSize					   OffsetAlignment	= 16;
+		VkDeviceSize					   NonCoherentAtom	= 1;
+		bool							   Coherent			= true;
+		VkDeviceSize					   Head				= 0;
+		VkDeviceSize					   Tail				= 0;
+		std::deque<Batch>				   InFlight;
+		std::vector<BufferCopy>			   PendingBufferCopies;
+		std::vector<ImageCopy>			   PendingImageCopies;
+		std::vector<VkImageMemoryBarrier>  PendingImageBarriers;
+		std::vector<VkMappedMemoryRange>   PendingFlushRanges;
+	};
+}
@@ -0,0 +1,159 @@
+#include "TransferContext.h"
+namespace VulkanCookbook {
+	bool TransferContext::Create(const LogicalDevice& device, VkQueue queue, uint32_t queueFamilyIndex) {
+		VkCommandPoolCreateInfo poolInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,												//sType
+			nullptr,																				//pNext
+			VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,	//flags
+			queueFamilyIndex																		//queueFamilyIndex
+		};
+		if (device.Dispatch.vkCreateCommandPool(device.Handle, &poolInfo, device.HostCallbacks, &CommandPool) != VK_SUCCESS) {
+			std::cout << "Could not create a command pool for the transfer context." << std::endl;
+			return false;
+		}
+		Device = &device;
+		SubmitQueue = queue;
+		FamilyIndex = queueFamilyIndex;
+		NextTicket = 1;
+		CompletedTicket = 0;
+		Statistics = {};
+		return true;
+	}
+
+	void TransferContext::Destroy() {
+		if (!Device)
+			return;
+		Wait(NextTicket - 1);
+		if (IsRecording) {
+			FreeBatches.push_back(Recording);
+			IsRecording = false;
+		}
+		for (auto& batch : FreeBatches)
+			Device->Dispatch.vkDestroyFence(Device->Handle, batch.Fence, Device->HostCallbacks);
+		FreeBatches.clear();
+		//destroying the pool frees its command buffers
+		Device->Dispatch.vkDestroyCommandPool(Device->Handle, CommandPool, Device->HostCallbacks);
+		CommandPool = VK_NULL_HANDLE;
+		Device = nullptr;
+	}
+
+	bool TransferContext::AcquireBatch(Batch& batch) {
+		auto& dispatch = Device->Dispatch;
+		Retire();
+		if (!FreeBatches.empty()) {
+			batch = FreeBatches.back();
+			FreeBatches.pop_back();
+			dispatch.vkResetFences(Device->Handle, 1, &batch.Fence);
+			dispatch.vkResetCommandBuffer(batch.CommandBuffer, 0);
+			return true;
+		}
+		VkCommandBufferAllocateInfo allocateInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,	//sType
+			nullptr,										//pNext
+			CommandPool,									//commandPool
+			VK_COMMAND_BUFFER_LEVEL_PRIMARY,				//level
+			1												//commandBufferCount
+		};
+		VkFenceCreateInfo fenceInfo = {
+			VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,	//sType
+			nullptr,								//pNext
+			0										//flags
+		};
+		if (dispatch.vkAllocateCommandBuffers(Device->Handle, &allocateInfo, &batch.CommandBuffer) != VK_SUCCESS)
+			return false;
+		if (dispatch.vkCreateFence(Device->Handle, &fenceInfo, Device->HostCallbacks, &batch.Fence) != VK_SUCCESS) {
+			dispatch.vkFreeCommandBuffers(Device->Handle, CommandPool, 1, &batch.CommandBuffer);
+			return false;
+		}
+		return true;
+	}
+
+	VkCommandBuffer TransferContext::Commands() {
+		if (IsRecording)
+			return Recording.CommandBuffer;
+		if (!AcquireBatch(Recording)) {
+			std::cout << "Could not create a transfer batch." << std::endl;
+			return VK_NULL_HANDLE;
+		}
+		VkCommandBufferBeginInfo beginInfo = {
+			VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,	//sType
+			nullptr,										//pNext
+			VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,	//flags
+			nullptr											//pInheritanceInfo
+		};
+		if (Device->Dispatch.vkBeginCommandBuffer(Recording.CommandBuffer, &beginInfo) != VK_SUCCESS) {
+			std::cout << "Could not begin a transfer batch." << std::endl;
+			FreeBatches.push_back(Recording);
+			return VK_NULL_HANDLE;
+		}
+		IsRecording = true;
+		return Recording.CommandBuffer;
+	}
+
+	bool TransferContext::Submit(uint64_t& ticket, VkSemaphore signalSemaphore) {
+		if (!IsRecording && (!signalSemaphore || !Commands())) {
+			ticket = NextTicket - 1;
+			return !signalSemaphore;
+		}
+		auto& dispatch = Device->Dispatch;
+		IsRecording = false;
+		if (dispatch.vkEndCommandBuffer(Recording.CommandBuffer) != VK_SUCCESS) {
+			std::cout << "Could not record a transfer batch." << std::endl;
+			FreeBatches.push_back(Recording);
+			return false;
+		}
+		VkSubmitInfo submitInfo = {
+			VK_STRUCTURE_TYPE_SUBMIT_INFO,	//sType
+			nullptr,						//pNext
+			0,								//waitSemaphoreCount
+			nullptr,						//pWaitSemaphores
+			nullptr,						//pWaitDstStageMask
+			1,								//commandBufferCount
+			&Recording.CommandBuffer,		//pCommandBuffers
+			signalSemaphore ? 1u : 0u,		//signalSemaphoreCount
+			&signalSemaphore				//pSignalSemaphores
+		};
+		if (dispatch.vkQueueSubmit(SubmitQueue, 1, &submitInfo, Recording.Fence) != VK_SUCCESS) {
+			std::cout << "Could not submit a transfer batch." << std::endl;
+			FreeBatches.push_back(Recording);
+			return false;
+		}
+		++Statistics.Submits;
+		Recording.Ticket = NextTicket++;
+		InFlight.push_back(Recording);
+		ticket = Recording.Ticket;
+		return true;
+	}
+
+	//fences of one queue signal in submission order, so batches finish front to back
+	void TransferContext::Retire() {
+		while (!InFlight.empty() && Device->Dispatch.vkGetFenceStatus(Device->Handle, InFlight.front().Fence) == VK_SUCCESS) {
+			CompletedTicket = InFlight.front().Ticket;
+			FreeBatches.push_back(InFlight.front());
+			InFlight.pop_front();
+		}
+	}
+
+	bool TransferContext::IsComplete(uint64_t ticket) {
+		if (ticket > CompletedTicket)
+			Retire();
+		return ticket <= CompletedTicket;
+	}
+
+	bool TransferContext::Wait(uint64_t ticket) {
+		while (ticket > CompletedTicket && !InFlight.empty()) {
+			if (Device->Dispatch.vkWaitForFences(Device->Handle, 1, &InFlight.front().Fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+				std::cout << "Could not wait for a transfer batch." << std::endl;
+				return false;
+			}
+			++Statistics.HostWaits;
+			Retire();
+		}
+		return ticket <= CompletedTicket;
+	}
+
+	bool TransferContext::WaitIdle() {
+		uint64_t ticket;
+		return Submit(ticket) && Wait(ticket);
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "Common.h"
+#include <deque>
+namespace VulkanCookbook {
+	struct TransferContextStats {
+		uint64_t Submits   = 0;
+		uint64_t HostWaits = 0;	//vkWaitForFences calls that Wait had to make
+	};
+
+	//Batches one-off GPU work (uploads, layout transitions, mipmap generation) into a shared command
+	//buffer and submits it without waiting for the queue. Every submit is identified by a ticket; tickets
+	//grow by one per submit, and a ticket is complete once its batch and every earlier one have finished.
+	//Work recorded into Commands() belongs to PendingTicket(). Callers keep the ticket and wait for it,
+	//or poll it, only when the host really needs the result; work on the same queue is ordered after the
+	//batch anyway, and work on another queue can wait for the semaphore passed to Submit.
+	class TransferContext {
+	 public:
+		bool Create(const LogicalDevice& device, VkQueue queue, uint32_t queueFamilyIndex);
+		//Waits for every submitted batch; an unsubmitted batch is discarded.
+		void Destroy();
+
+		//The command buffer of the batch being recorded, begun on first use. VK_NULL_HANDLE on failure.
+		VkCommandBuffer Commands();
+		uint64_t PendingTicket() const { return NextTicket; }
+		//Submits the batch being recorded. With nothing recorded, ticket is the last submitted one (0 if
+		//there is none) and nothing is submitted unless a semaphore has to be signalled.
+		bool Submit(uint64_t& ticket, VkSemaphore signalSemaphore = VK_NULL_HANDLE);
+		bool IsComplete(uint64_t ticket);
+		bool Wait(uint64_t ticket);
+		//Submits the batch being recorded and waits for everything.
+		bool WaitIdle();
+
+		const TransferContextStats& Stats() const { return Statistics; }
+		VkQueue Queue() const { return SubmitQueue; }
+		uint32_t QueueFamilyIndex() const { return FamilyIndex; }
+	 private:
+		struct Batch {
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			VkFence			Fence		  = VK_NULL_HANDLE;
+			uint64_t		Ticket		  = 0;
+		};
+
+		bool AcquireBatch(Batch& batch);
+		void Retire();
+
+		const LogicalDevice* Device			 = nullptr;
+		VkQueue				 SubmitQueue	 = VK_NULL_HANDLE;
+		uint32_t			 FamilyIndex	 = 0;
+		VkCommandPool		 CommandPool	 = VK_NULL_HANDLE;
+		Batch				 Recording;
+		bool				 IsRecording	 = false;
+		uint64_t			 NextTicket		 = 1;
+		uint64_t			 CompletedTicket = 0;
+		std::deque<Batch>	 InFlight;
+		std::vector<Batch>	 FreeBatches;
+		TransferContextStats Statistics;
+	};
+}
@@ -0,0 +1,138 @@
+#include "TransientImagePool.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	namespace {
+		VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	void TransientImagePool::Create(DeviceMemoryAllocator& allocator) {
+		Allocator = &allocator;
+	}
+
+	void TransientImagePool::Destroy() {
+		if (!Allocator)
+			return;
+		Reset();
+		Allocator->Free(Shared);
+		Allocator = nullptr;
+	}
+
+	bool TransientImagePool::CreateImage(const VkImageCreateInfo& imageInfo, uint32_t firstPass, uint32_t lastPass, VkImage& image) {
+		auto& device = Allocator->Device();
+		if (device.Dispatch.vkCreateImage(device.Handle, &imageInfo, device.HostCallbacks, &image) != VK_SUCCESS) {
+			std::cout << "Could not create a transient image." << std::endl;
+			return false;
+		}
+		Slot slot = {};
+		slot.Image = image;
+		slot.FirstPass = firstPass;
+		slot.LastPass = lastPass;
+		device.Dispatch.vkGetImageMemoryRequirements(device.Handle, image, &slot.Requirements);
+		Slots.push_back(slot);
+		Requested += slot.Requirements.size;
+		return true;
+	}
+
+	bool TransientImagePool::Bind() {
+		auto& device = Allocator->Device();
+		MemoryTypePreference lazyPreference;
+		lazyPreference.Required = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+		std::vector<Slot*> aliased;
+		for (auto& slot : Slots) {
+			if (slot.Bound)
+				continue;
+			uint32_t lazyType;
+			if (!Allocator->DeviceInfo().FindMemoryType(slot.Requirements.memoryTypeBits, lazyPreference, lazyType)) {
+				aliased.push_back(&slot);
+				continue;
+			}
+			AllocationCreateInfo allocationInfo;
+			allocationInfo.RequiredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+			allocationInfo.Kind = ResourceKind::Optimal;
+			allocationInfo.Dedicated = true;
+			allocationInfo.Category = MemoryCategory::Attachment;
+			if (!Allocator->Allocate(slot.Requirements, allocationInfo, slot.LazyMemory) ||
+				device.Dispatch.vkBindImageMemory(device.Handle, slot.Image, slot.LazyMemory.Memory, slot.LazyMemory.Offset) != VK_SUCCESS) {
+				std::cout << "Could not bind lazily allocated memory to a transient image." << std::endl;
+				return false;
+			}
+			slot.Bound = true;
+			Lazy += slot.LazyMemory.Size;
+		}
+		if (aliased.empty())
+			return true;
+
+		//largest first; each image goes to the lowest offset that no image with an overlapping pass
+		//range occupies, including the images bound by earlier calls
+		std::vector<Slot*> placed;
+		for (auto& slot : Slots)
+			if (slot.Bound && !slot.LazyMemory.Memory)
+				placed.push_back(&slot);
+		std::sort(aliased.begin(), aliased.end(), [](const Slot* a, const Slot* b) {
+			return a->Requirements.size > b->Requirements.size;
+		});
+		VkMemoryRequirements sharedRequirements = { 0, 1, ~0u };
+		for (Slot* slot : placed) {
+			sharedRequirements.size = std::max(sharedRequirements.size, slot->Offset + slot->Requirements.size);
+			sharedRequirements.alignment = std::max(sharedRequirements.alignment, slot->Requirements.alignment);
+			sharedRequirements.memoryTypeBits &= slot->Requirements.memoryTypeBits;
+		}
+		for (Slot* slot : aliased) {
+			auto overlaps = [slot](const Slot* other) {
+				return other->FirstPass <= slot->LastPass && slot->FirstPass <= other->LastPass;
+			};
+			VkDeviceSize offset = 0;
+			for (bool moved = true; moved;) {
+				moved = false;
+				for (const Slot* other : placed)
+					if (overlaps(other) && offset < other->Offset + other->Requirements.size && other->Offset < offset + slot->Requirements.size) {
+						offset = AlignUp(other->Offset + other->Requirements.size, slot->Requirements.alignment);
+						moved = true;
+					}
+			}
+			slot->Offset = offset;
+			placed.push_back(slot);
+			sharedRequirements.size = std::max(sharedRequirements.size, offset + slot->Requirements.size);
+			sharedRequirements.alignment = std::max(sharedRequirements.alignment, slot->Requirements.alignment);
+			sharedRequirements.memoryTypeBits &= slot->Requirements.memoryTypeBits;
+		}
+
+		bool reuse = Shared.Memory && Shared.Size >= sharedRequirements.size && Shared.Offset % sharedRequirements.alignment == 0 &&
+					 (sharedRequirements.memoryTypeBits & (1u << Shared.MemoryTypeIndex));
+		if (!reuse) {
+			if (placed.size() > aliased.size()) {
+				std::cout << "Transient images bound earlier do not fit the shared allocation; call Reset first." << std::endl;
+				return false;
+			}
+			Allocator->Free(Shared);
+			AllocationCreateInfo allocationInfo;
+			allocationInfo.RequiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			allocationInfo.Kind = ResourceKind::Optimal;
+			allocationInfo.Category = MemoryCategory::Attachment;
+			if (!Allocator->Allocate(sharedRequirements, allocationInfo, Shared))
+				return false;
+		}
+		for (Slot* slot : aliased) {
+			if (device.Dispatch.vkBindImageMemory(device.Handle, slot->Image, Shared.Memory, Shared.Offset + slot->Offset) != VK_SUCCESS) {
+				std::cout << "Could not bind shared memory to a transient image." << std::endl;
+				return false;
+			}
+			slot->Bound = true;
+		}
+		return true;
+	}
+
+	void TransientImagePool::Reset() {
+		auto& device = Allocator->Device();
+		for (auto& slot : Slots) {
+			device.Dispatch.vkDestroyImage(device.Handle, slot.Image, device.HostCallbacks);
+			Allocator->Free(slot.LazyMemory);
+		}
+		Slots.clear();
+		Requested = 0;
+		Lazy = 0;
+	}
+}
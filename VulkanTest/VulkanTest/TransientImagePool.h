@@ -0,0 +1,43 @@
+#pragma once
+#include "MemoryAllocator.h"
+namespace VulkanCookbook {
+	//Memory for attachments that only live within a frame, such as MSAA color and depth. Images go to
+	//LAZILY_ALLOCATED memory when the device has it; tile-based GPUs never back that memory with pages
+	//if the attachment is not loaded or stored. Otherwise all images share one allocation, and images
+	//whose pass ranges do not overlap alias the same bytes. Because of that, an image's contents are
+	//undefined at the start of its first pass (initialLayout UNDEFINED, loadOp CLEAR or DONT_CARE).
+	//The shared allocation survives Reset, so recreating attachments of the same or smaller size (a
+	//swapchain resize) does not allocate again.
+	class TransientImagePool {
+	 public:
+		void Create(DeviceMemoryAllocator& allocator);
+		void Destroy();
+
+		//The image is used from pass firstPass to lastPass, inclusive. It has no memory until Bind.
+		bool CreateImage(const VkImageCreateInfo& imageInfo, uint32_t firstPass, uint32_t lastPass, VkImage& image);
+		//Gives memory to every image created since the last Bind.
+		bool Bind();
+		//Destroys the images; the shared allocation is kept for the next set.
+		void Reset();
+
+		VkDeviceSize RequestedBytes() const { return Requested; }	//what separate allocations would take
+		VkDeviceSize SharedBytes() const	{ return Shared.Size; }
+		VkDeviceSize LazyBytes() const		{ return Lazy; }
+	 private:
+		struct Slot {
+			VkImage				 Image;
+			VkMemoryRequirements Requirements;
+			uint32_t			 FirstPass;
+			uint32_t			 LastPass;
+			VkDeviceSize		 Offset;			//in the shared allocation
+			Allocation			 LazyMemory;
+			bool				 Bound;
+		};
+
+		DeviceMemoryAllocator* Allocator = nullptr;
+		std::vector<Slot>	   Slots;
+		Allocation			   Shared;
+		VkDeviceSize		   Requested = 0;
+		VkDeviceSize		   Lazy		 = 0;
+	};
+}
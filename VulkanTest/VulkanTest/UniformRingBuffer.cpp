@@ -0,0 +1,88 @@
+#include "UniformRingBuffer.h"
+#include <algorithm>
+namespace VulkanCookbook {
+	namespace {
+		VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	bool UniformRingBuffer::Create(DeviceMemoryAllocator& allocator, VkDeviceSize bytesPerFrame, uint32_t frameCount) {
+		auto& limits = allocator.DeviceInfo().Limits();
+		NonCoherentAtom = std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1);
+		//both limits are powers of two, so the larger one satisfies both
+		OffsetAlignment = std::max<VkDeviceSize>({ limits.minUniformBufferOffsetAlignment, NonCoherentAtom, 1 });
+		PartitionSize = AlignUp(bytesPerFrame, OffsetAlignment);
+		if (PartitionSize * frameCount > UINT32_MAX) {
+			std::cout << "Uniform ring buffer does not fit 32-bit dynamic offsets." << std::endl;
+			return false;
+		}
+
+		VkBufferCreateInfo bufferInfo = {
+			VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,	//sType
+			nullptr,								//pNext
+			0,										//flags
+			PartitionSize * frameCount,				//size
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,		//usage
+			VK_SHARING_MODE_EXCLUSIVE,				//sharingMode
+			0,										//queueFamilyIndexCount
+			nullptr									//pQueueFamilyIndices
+		};
+		AllocationCreateInfo allocationInfo;
+		allocationInfo.RequiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		//device-local when the device exposes such a host-visible type, so shaders read from VRAM
+		allocationInfo.PreferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		allocationInfo.Category = MemoryCategory::Uniform;
+		if (!allocator.CreateBuffer(bufferInfo, allocationInfo, RingBuffer, Memory))
+			return false;
+
+		Allocator = &allocator;
+		Coherent = allocator.DeviceInfo().MemoryProperties().memoryTypes[Memory.MemoryTypeIndex].propertyFlags &
+				   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		FrameCount = frameCount;
+		CurrentFrame = 0;
+		Head = 0;
+		return true;
+	}
+
+	void UniformRingBuffer::Destroy() {
+		if (Allocator) {
+			Allocator->DestroyBuffer(RingBuffer, Memory);
+			Allocator = nullptr;
+		}
+	}
+
+	void UniformRingBuffer::BeginFrame(uint32_t frameIndex) {
+		CurrentFrame = frameIndex % FrameCount;
+		Head = 0;
+	}
+
+	bool UniformRingBuffer::Allocate(VkDeviceSize size, void*& data, uint32_t& dynamicOffset) {
+		VkDeviceSize offset = AlignUp(Head, OffsetAlignment);
+		if (offset + size > PartitionSize) {
+			std::cout << "Uniform ring buffer partition is full." << std::endl;
+			return false;
+		}
+		Head = offset + size;
+		dynamicOffset = static_cast<uint32_t>(FrameOffset(CurrentFrame) + offset);
+		data = static_cast<char*>(Memory.Mapped) + dynamicOffset;
+		return true;
+	}
+
+	void UniformRingBuffer::EndFrame() {
+		if (Coherent || Head == 0)
+			return;
+		//flushed ranges are relative to the VkDeviceMemory and must be multiples of nonCoherentAtomSize
+		VkDeviceSize begin = (Memory.Offset + FrameOffset(CurrentFrame)) / NonCoherentAtom * NonCoherentAtom;
+		VkDeviceSize end = AlignUp(Memory.Offset + FrameOffset(CurrentFrame) + Head, NonCoherentAtom);
+		VkMappedMemoryRange range = {
+			VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,	//sType
+			nullptr,								//pNext
+			Memory.Memory,							//memory
+			begin,									//offset
+			end - begin								//size
+		};
+		auto& device = Allocator->Device();
+		device.Dispatch.vkFlushMappedMemoryRanges(device.Handle, 1, &range);
+	}
+}
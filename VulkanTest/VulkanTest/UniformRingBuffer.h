@@ -0,0 +1,41 @@
+#pragma once
+#include "MemoryAllocator.h"
+namespace VulkanCookbook {
+	//One persistently mapped uniform buffer split into a partition per frame. Each frame's uniform
+	//data is bump-allocated into its partition and bound with VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+	//offsets: no map/unmap per update and no buffer or allocation per object.
+	class UniformRingBuffer {
+	 public:
+		bool Create(DeviceMemoryAllocator& allocator, VkDeviceSize bytesPerFrame, uint32_t frameCount);
+		void Destroy();
+
+		//The GPU must be done with the frame's partition, i.e. its fence has been waited on.
+		void BeginFrame(uint32_t frameIndex);
+		bool Allocate(VkDeviceSize size, void*& data, uint32_t& dynamicOffset);
+		template<typename T>
+		bool Push(const T& value, uint32_t& dynamicOffset) {
+			void* data;
+			if (!Allocate(sizeof(T), data, dynamicOffset))
+				return false;
+			memcpy(data, &value, sizeof(T));
+			return true;
+		}
+		//Flushes this frame's writes when the memory is not host-coherent.
+		void EndFrame();
+
+		VkBuffer	 Buffer() const						   { return RingBuffer; }
+		VkDeviceSize Alignment() const					   { return OffsetAlignment; }
+		VkDeviceSize FrameOffset(uint32_t frameIndex) const { return frameIndex * PartitionSize; }
+	 private:
+		DeviceMemoryAllocator* Allocator		= nullptr;
+		VkBuffer			   RingBuffer		= VK_NULL_HANDLE;
+		Allocation			   Memory;
+		bool				   Coherent			= true;
+		VkDeviceSize		   NonCoherentAtom	= 1;
+		VkDeviceSize		   OffsetAlignment	= 1;
+		VkDeviceSize		   PartitionSize	= 0;
+		uint32_t			   FrameCount		= 0;
+		uint32_t			   CurrentFrame		= 0;
+		VkDeviceSize		   Head				= 0;	//relative to the current partition
+	};
+}
@@ -9,4 +9,20 @@ namespace VulkanCookbook {
 	#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension ) extern PFN_##name name;
 
 	#include "ListOfVulkanFunctions.inl"
+
+	//Per-instance and per-device copies of the entry points above, so that several
+	//instances/devices can live side by side without overwriting each other's pointers.
+	struct InstanceDispatchTable {
+		#define INSTANCE_LEVEL_VULKAN_FUNCTION( name ) PFN_##name name = nullptr;
+		#define INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension ) PFN_##name name = nullptr;
+
+		#include "ListOfVulkanFunctions.inl"
+	};
+
+	struct DeviceDispatchTable {
+		#define DEVICE_LEVEL_VULKAN_FUNCTION( name ) PFN_##name name = nullptr;
+		#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension ) PFN_##name name = nullptr;
+
+		#include "ListOfVulkanFunctions.inl"
+	};
 }
\ No newline at end of file
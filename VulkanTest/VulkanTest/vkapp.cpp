@@ -1,6 +1,30 @@
 #include "vkapp.h"
 
 namespace VulkanCookbook {
+	vkapp::FunctionLoadingTimings vkapp::functionLoadingTimings;
+	HostArena vkapp::instanceHostArena("Instance");
+	HostArena vkapp::deviceHostArena("Device");
+	std::optional<ExtensionSet> vkapp::instanceExtensionCache;
+	std::unordered_map<VkPhysicalDevice, PhysicalDeviceInfo> vkapp::physicalDeviceInfoCache;
+
+	void vkapp::reportFunctionLoadingTimings() {
+		auto report = [](const char* loader, Milliseconds elapsed) {
+			//a loader that never ran has nothing to report
+			if (elapsed.count() > 0.0)
+				std::cout << loader << elapsed.count() << " ms" << std::endl;
+		};
+		report("LoadGlobalLevelFunctions:   ", functionLoadingTimings.GlobalLevel);
+		report("LoadInstanceLevelFunctions: ", functionLoadingTimings.InstanceLevel);
+		report("loadDeviceLevelFunctions:   ", functionLoadingTimings.DeviceLevel);
+		report("loadInstanceDispatchTable:  ", functionLoadingTimings.InstanceDispatchTable);
+		report("loadDeviceDispatchTable:    ", functionLoadingTimings.DeviceDispatchTable);
+	}
+
+	void vkapp::reportHostAllocations() {
+		instanceHostArena.PrintStats();
+		deviceHostArena.PrintStats();
+	}
+
 	bool vkapp::LoadFunctionExportedFromVulkanLoaderLibrary(LIBRARY_TYPE const & vulkan_library){
 		#if defined _WIN32
 		#define LoadFunction GetProcAddress
@@ -30,6 +54,7 @@ namespace VulkanCookbook {
 		return true;
 	}
 	bool vkapp::LoadGlobalLevelFunctions() {
+		ScopedTimer timer(functionLoadingTimings.GlobalLevel);
 		#define	GLOBAL_LEVEL_VULKAN_FUNCTION( name )								\
 		name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr( nullptr, #name));\
 		if(!name){																	\
@@ -40,6 +65,15 @@ namespace VulkanCookbook {
 		#include "ListOfVulkanFunctions.inl"
 		return true;
 	}
+	bool vkapp::loadVulkanLibrary(LIBRARY_TYPE& vulkanLibrary) {
+		if (!ConnectWithVulkanLoaderLibrary(vulkanLibrary))
+			return false;
+		if (!LoadFunctionExportedFromVulkanLoaderLibrary(vulkanLibrary) || !LoadGlobalLevelFunctions()) {
+			releaseVulkanLoaderLibrary(vulkanLibrary);
+			return false;
+		}
+		return true;
+	}
 	bool vkapp::CheckAvailableInstanceExtensions(std::vector<VkExtensionProperties>& availableExtensions){
 		uint32_t extensionsCount;
 		VkResult result = VK_SUCCESS;
@@ -58,13 +92,22 @@ namespace VulkanCookbook {
 		}
 		return true;
 	}
-	bool vkapp::CreateVulkanInstance(std::vector<char const *> const& desiredExtensions, const char* const applicationName, 
+	const ExtensionSet* vkapp::getAvailableInstanceExtensions() {
+		if (!instanceExtensionCache) {
+			std::vector<VkExtensionProperties> availableExtensions;
+			if (!CheckAvailableInstanceExtensions(availableExtensions))
+				return nullptr;
+			instanceExtensionCache.emplace(availableExtensions);
+		}
+		return &*instanceExtensionCache;
+	}
+		bool vkapp::CreateVulkanInstance(std::vector<char const *> const& desiredExtensions, const char* const applicationName, 
 									 VkInstance& instance) {
-		std::vector<VkExtensionProperties> availableExtensions;
-		if (!CheckAvailableInstanceExtensions(availableExtensions))
+		const ExtensionSet* availableExtensions = getAvailableInstanceExtensions();
+		if (!availableExtensions)
 			return false;
 		for (auto& extension : desiredExtensions) 
-			if (!IsExtensionSupported(availableExtensions, extension)) {
+			if (!IsExtensionSupported(*availableExtensions, extension)) {
 				std::cout << "Extension named '" << extension << "' is not supported." << std::endl;
 				return false;
 			}
@@ -90,13 +133,34 @@ namespace VulkanCookbook {
 			desiredExtensions.data() : nullptr		
 		};
 		
-		if (vkCreateInstance(&instanceCreateInfo, nullptr, &instance)!= VK_SUCCESS) {
+		if (vkCreateInstance(&instanceCreateInfo, instanceHostArena.Callbacks(), &instance)!= VK_SUCCESS) {
+			std::cout << "Error creating instance!" << std::endl;
+			return false;
+		}
+		return true;
+	}
+	bool vkapp::createVulkanInstance(const VkInstanceCreateInfo& createInfo, const VkAllocationCallbacks* hostCallbacks,
+									 VulkanInstance& instance) {
+		if (vkCreateInstance(&createInfo, hostCallbacks, &instance.Handle) != VK_SUCCESS) {
 			std::cout << "Error creating instance!" << std::endl;
 			return false;
 		}
+		instance.HostCallbacks = hostCallbacks;
+		std::vector<const char*> enabledExtensions;
+		if (createInfo.enabledExtensionCount > 0)
+			enabledExtensions.assign(createInfo.ppEnabledExtensionNames, createInfo.ppEnabledExtensionNames + createInfo.enabledExtensionCount);
+		//the globals serve the helpers here, such as rankPhysicalDevices and PhysicalDeviceInfo
+		if (!LoadInstanceLevelFunctions(instance.Handle, enabledExtensions) ||
+			!loadInstanceDispatchTable(instance.Handle, enabledExtensions, instance.Dispatch)) {
+			destroyInstance(instance);
+			return false;
+		}
 		return true;
 	}
 	bool vkapp::LoadInstanceLevelFunctions(VkInstance instance, const std::vector<const char*>& enabledExtensions) {
+		ScopedTimer timer(functionLoadingTimings.InstanceLevel);
+		ExtensionSet enabled(enabledExtensions);
+
 		#define INSTANCE_LEVEL_VULKAN_FUNCTION( name )								   \
 		name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr( instance , #name ));\
 		if(name == nullptr){														   \
@@ -105,17 +169,18 @@ namespace VulkanCookbook {
 				return false;														   \
 		}
 
-		#define INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension )        \
-		    for( auto & enabled_extension : enabledExtensions ) {                       \
-		      if( std::string( enabled_extension ) == std::string( extension ) ) {      \
-		        name = (PFN_##name)vkGetInstanceProcAddr( instance, #name );            \
-		        if( name == nullptr ) {                                                 \
-		          std::cout << "Could not load instance-level Vulkan function named: "  \
-		            #name << std::endl;                                                 \
-		          return false;                                                         \
-		        }                                                                       \
-		      }                                                                         \
-		    }
+		#define INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension )				\
+		{																						\
+			constexpr uint64_t extensionHash = HashExtensionName( extension );					\
+			if( enabled.Contains( extensionHash, extension ) ) {								\
+				name = (PFN_##name)vkGetInstanceProcAddr( instance, #name );					\
+				if( name == nullptr ){															\
+						std::cout << "Could not load instance-level Vulkan function named: "	\
+								  << #name << std::endl;										\
+						return false;															\
+				}																				\
+			}																					\
+		}
 
 		#include "ListOfVulkanFunctions.inl"
 		return true;
@@ -136,6 +201,19 @@ namespace VulkanCookbook {
 		}
 		return true;
 	}
+	bool vkapp::rankPhysicalDevices(VkInstance instance, const DeviceRankingPolicy& policy, std::vector<DeviceScore>& ranking) {
+		std::vector<VkPhysicalDevice> physicalDevices;
+		if (!EnumerateAvailablePhysicalDevices(instance, physicalDevices))
+			return false;
+		std::vector<const PhysicalDeviceInfo*> devices;
+		for (auto physicalDevice : physicalDevices)
+			if (const PhysicalDeviceInfo* deviceInfo = getPhysicalDeviceInfo(physicalDevice))
+				devices.push_back(deviceInfo);
+		ranking = RankPhysicalDevices(devices, policy);
+		for (auto& score : ranking)
+			PrintDeviceScore(score);
+		return !ranking.empty();
+	}
 	bool vkapp::checkAvailableDeviceExtensions(VkPhysicalDevice physicalDevice, 
 											   std::vector<VkExtensionProperties>& availableExtensions){
 		uint32_t extensionsCount = 0;
@@ -151,7 +229,32 @@ namespace VulkanCookbook {
 			std::cout << "Could not enumerate device extension properties." << std::endl;
 			return false;
 		}
-		return false;
+		return true;
+	}
+	const ExtensionSet* vkapp::getAvailableDeviceExtensions(VkPhysicalDevice physicalDevice) {
+		const PhysicalDeviceInfo* deviceInfo = getPhysicalDeviceInfo(physicalDevice);
+		return deviceInfo ? &deviceInfo->Extensions() : nullptr;
+	}
+	const PhysicalDeviceInfo* vkapp::getPhysicalDeviceInfo(VkPhysicalDevice physicalDevice) {
+		if (auto cached = physicalDeviceInfoCache.find(physicalDevice); cached != physicalDeviceInfoCache.end())
+			return &cached->second;
+
+		std::vector<VkExtensionProperties> availableExtensions;
+		std::vector<VkQueueFamilyProperties> queueFamilies;
+		if (!checkAvailableDeviceExtensions(physicalDevice, availableExtensions) ||
+			!checkAvailableQueueFamiliesAndTheirProperties(physicalDevice, queueFamilies))
+			return nullptr;
+
+		VkPhysicalDeviceFeatures deviceFeatures;
+		VkPhysicalDeviceProperties deviceProperties;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		getFeaturesAndPropertiesOfPhysicalDevice(physicalDevice, deviceFeatures, deviceProperties);
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		return &physicalDeviceInfoCache.emplace(physicalDevice,
+												PhysicalDeviceInfo(physicalDevice, deviceFeatures, deviceProperties,
+																   std::move(queueFamilies), memoryProperties,
+																   ExtensionSet(availableExtensions))).first->second;
 	}
 	void vkapp::getFeaturesAndPropertiesOfPhysicalDevice(VkPhysicalDevice physicalDevice, 
 														 VkPhysicalDeviceFeatures& deviceFeatures, 
@@ -178,12 +281,13 @@ namespace VulkanCookbook {
 	}
 	bool vkapp::selectIndexOfQueueFamilyWithDesiredCapabilities(VkPhysicalDevice physicalDevice, VkQueueFlags desiredFlags,
 		uint32_t& queueFamilyIndex) {
-		std::vector<VkQueueFamilyProperties> queueFamilies;
-		if(!checkAvailableQueueFamiliesAndTheirProperties(physicalDevice, queueFamilies))
+		const PhysicalDeviceInfo* deviceInfo = getPhysicalDeviceInfo(physicalDevice);
+		if (!deviceInfo)
 			return false;
+		auto& queueFamilies = deviceInfo->QueueFamilies();
 
 		for (uint32_t index = 0; index < static_cast<uint32_t>(queueFamilies.size()); ++index)
-			if ((queueFamilies[index].queueCount > 0) && (desiredFlags & queueFamilies[index].queueFlags)){
+			if ((queueFamilies[index].queueCount > 0) && ((queueFamilies[index].queueFlags & desiredFlags) == desiredFlags)){
 				queueFamilyIndex = index;
 				return true;
 			}
@@ -195,13 +299,14 @@ namespace VulkanCookbook {
 									std::vector<QueueInfo> queueInfos,
 									const std::vector<const char*>& desiredExtensions, 
 									VkPhysicalDeviceFeatures* desiredFeatures,
-									VkDevice logicalDevice) {
-		std::vector<VkExtensionProperties> availableExtensions;
-		if (!checkAvailableDeviceExtensions(physicalDevice, availableExtensions))
+									VkDevice& logicalDevice,
+									const void* next) {
+		const ExtensionSet* availableExtensions = getAvailableDeviceExtensions(physicalDevice);
+		if (!availableExtensions)
 			return false;
 
 		for (auto& extension : desiredExtensions)
-			if (!IsExtensionSupported(availableExtensions, extension)) {
+			if (!IsExtensionSupported(*availableExtensions, extension)) {
 				std::cout << "Extension named '" << extension << "' is not supported by a physical device." << std::endl;
 				return  false;
 			}
@@ -219,7 +324,7 @@ namespace VulkanCookbook {
 
 		VkDeviceCreateInfo deviceCreateInfo = {
 			VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,		    //sType
-			nullptr,										//pNext
+			next,											//pNext
 			0,												//flags
 			static_cast<uint32_t>(queueCreateInfos.size()), //queueCreateInfoCount
 			queueCreateInfos.data(),					    //pQueueCreateInfos
@@ -229,17 +334,19 @@ namespace VulkanCookbook {
 			desiredExtensions.data(),						//ppenabledExtensionCount
 			desiredFeatures									//pEnabledFeatures
 		};
-		if (VkResult result = vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &logicalDevice);
+		if (VkResult result = vkCreateDevice(physicalDevice, &deviceCreateInfo, deviceHostArena.Callbacks(), &logicalDevice);
 		result != VK_SUCCESS) {
 			std::cout << "Error creating logical device!" << std::endl;
 			return false;
 		}
 
-		return false;
+		return true;
 	}
 
 	bool vkapp::loadDeviceLevelFunctions(VkDevice logicalDevice,
 		const std::vector<const char*>& enabledExtensions) {
+			ScopedTimer timer(functionLoadingTimings.DeviceLevel);
+			ExtensionSet enabled(enabledExtensions);
 
 			#define DEVICE_LEVEL_VULKAN_FUNCTION( name )							    \
 			name  = (PFN_##name)vkGetDeviceProcAddr( logicalDevice, #name );			\
@@ -249,74 +356,206 @@ namespace VulkanCookbook {
 						return false;													\
 			}
 
-			#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension )				\
-			for(auto& enabledExtensions : enabledExtensions)									\
-				if (std::string(enabledExtensions) == std::string(extension)) {					\
-					name = (PFN_##name)vkGetDeviceProcAddr( logicalDevice, #name );				\
-					if(name == nullptr){														\
-							std::cout << "Could not load device-level Vulkan function named: "	\
-									  << #name << std::endl;									\
-							return false;														\
-					}																			\
-				}																				
+			#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension )					\
+			{																						\
+				constexpr uint64_t extensionHash = HashExtensionName( extension );					\
+				if( enabled.Contains( extensionHash, extension ) ) {							\
+					name = (PFN_##name)vkGetDeviceProcAddr( logicalDevice, #name );					\
+					if( name == nullptr ){															\
+							std::cout << "Could not load device-level Vulkan function named: "		\
+									  << #name << std::endl;										\
+							return false;															\
+					}																				\
+				}																					\
+			}
 			
 		#include "ListOfVulkanFunctions.inl"
 		return true;
 	}
 
+	bool vkapp::loadInstanceDispatchTable(VkInstance instance, const std::vector<const char*>& enabledExtensions,
+										  InstanceDispatchTable& dispatchTable) {
+		ScopedTimer timer(functionLoadingTimings.InstanceDispatchTable);
+		ExtensionSet enabled(enabledExtensions);
+
+		#define INSTANCE_LEVEL_VULKAN_FUNCTION( name )											\
+		dispatchTable.name = (PFN_##name)vkGetInstanceProcAddr( instance, #name );				\
+		if( dispatchTable.name == nullptr ){													\
+				std::cout << "Could not load instance-level Vulkan function named: "			\
+						  << #name << std::endl;												\
+				return false;																	\
+		}
+
+		#define INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension )				\
+		{																						\
+			constexpr uint64_t extensionHash = HashExtensionName( extension );					\
+			if( enabled.Contains( extensionHash, extension ) ) {								\
+				dispatchTable.name = (PFN_##name)vkGetInstanceProcAddr( instance, #name );		\
+				if( dispatchTable.name == nullptr ){											\
+						std::cout << "Could not load instance-level Vulkan function named: "	\
+								  << #name << std::endl;										\
+						return false;															\
+				}																				\
+			}																					\
+		}
+
+		#include "ListOfVulkanFunctions.inl"
+		return true;
+	}
+
+	bool vkapp::loadDeviceDispatchTable(VkDevice logicalDevice, const std::vector<const char*>& enabledExtensions,
+										DeviceDispatchTable& dispatchTable) {
+		ScopedTimer timer(functionLoadingTimings.DeviceDispatchTable);
+		ExtensionSet enabled(enabledExtensions);
+
+		//vkGetDeviceProcAddr hands back the driver's own entry points, so calls made
+		//through the table skip the loader trampoline that dispatches on the device handle.
+		#define DEVICE_LEVEL_VULKAN_FUNCTION( name )											\
+		dispatchTable.name = (PFN_##name)vkGetDeviceProcAddr( logicalDevice, #name );			\
+		if( dispatchTable.name == nullptr ){													\
+				std::cout << "Could not load device-level Vulkan function named: "				\
+						  << #name << std::endl;												\
+				return false;																	\
+		}
+
+		#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension )					\
+		{																						\
+			constexpr uint64_t extensionHash = HashExtensionName( extension );					\
+			if( enabled.Contains( extensionHash, extension ) ) {								\
+				dispatchTable.name = (PFN_##name)vkGetDeviceProcAddr( logicalDevice, #name );	\
+				if( dispatchTable.name == nullptr ){											\
+						std::cout << "Could not load device-level Vulkan function named: "		\
+								  << #name << std::endl;										\
+						return false;															\
+				}																				\
+			}																					\
+		}
+
+		#include "ListOfVulkanFunctions.inl"
+		return true;
+	}
+
 	void vkapp::getDeviceQueue(VkDevice logicalDevice, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue& queue){
 		vkGetDeviceQueue( logicalDevice, queueFamilyIndex, queueIndex, &queue);
 	}
 
-	bool vkapp::createLogicalDeviceWithGeometryShadersAndGraphicsAndComputeQueues(VkInstance	instance, 
-																				  VkDevice& logicalDevice, 
-																				  VkQueue&	graphicsQueue, 
-																				  VkQueue&	computeQueue){
-		std::vector<VkPhysicalDevice> physicalDevices;
-		if (!EnumerateAvailablePhysicalDevices(instance, physicalDevices))
+	void vkapp::getDeviceQueue(const LogicalDevice& logicalDevice, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue& queue){
+		logicalDevice.Dispatch.vkGetDeviceQueue( logicalDevice.Handle, queueFamilyIndex, queueIndex, &queue);
+	}
+
+	bool vkapp::planQueues(VkPhysicalDevice physicalDevice, VkSurfaceKHR presentationSurface, uint32_t workloads, QueuePlan& plan){
+		const PhysicalDeviceInfo* deviceInfo = getPhysicalDeviceInfo(physicalDevice);
+		if (!deviceInfo)
 			return false;
-		for (auto physicalDevice : physicalDevices) {
-			VkPhysicalDeviceFeatures deviceFeatures;
-			VkPhysicalDeviceProperties deviceProperties;
-			getFeaturesAndPropertiesOfPhysicalDevice(physicalDevice, deviceFeatures, deviceProperties);
-			if (deviceFeatures.geometryShader == VK_TRUE) {
-				deviceFeatures = {};
-				deviceFeatures.geometryShader = VK_TRUE;
-			}
-			else
-				continue;
-			uint32_t graphicsQueueFamilyIndex, computeQueueFamilyIndex;
-			if (!selectIndexOfQueueFamilyWithDesiredCapabilities(physicalDevice, VK_QUEUE_GRAPHICS_BIT, graphicsQueueFamilyIndex))
-				continue;
-			if (!selectIndexOfQueueFamilyWithDesiredCapabilities(physicalDevice, VK_QUEUE_COMPUTE_BIT, computeQueueFamilyIndex))
+		std::vector<VkBool32> presentSupport;
+		if (presentationSurface != VK_NULL_HANDLE) {
+			presentSupport.resize(deviceInfo->QueueFamilies().size(), VK_FALSE);
+			for (uint32_t index = 0; index < static_cast<uint32_t>(presentSupport.size()); ++index)
+				if (vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, index, presentationSurface, &presentSupport[index]) != VK_SUCCESS)
+					presentSupport[index] = VK_FALSE;
+		}
+		return PlanQueues(*deviceInfo, presentSupport, workloads, QueuePriorities(), plan);
+	}
+
+	bool vkapp::createLogicalDeviceWithQueuePlan(VkPhysicalDevice				 physicalDevice,
+												 const QueuePlan&				 plan,
+												 const std::vector<const char*>& desiredExtensions,
+												 VkPhysicalDeviceFeatures*		 desiredFeatures,
+												 LogicalDevice&					 logicalDevice,
+												 QueueMap&						 queues,
+												 const void*					 next){
+		std::vector<QueueInfo> requestedQueues;
+		for (auto& request : plan.FamilyRequests())
+			requestedQueues.push_back({ request.FamilyIndex, request.Priorities });
+		if (!createLogicalDevice(physicalDevice, requestedQueues, desiredExtensions, desiredFeatures, logicalDevice.Handle, next))
+			return false;
+		logicalDevice.HostCallbacks = deviceHostArena.Callbacks();
+		if (!loadDeviceDispatchTable(logicalDevice.Handle, desiredExtensions, logicalDevice.Dispatch)) {
+			destroyLogicalDevice(logicalDevice);
+			return false;
+		}
+		logicalDevice.PhysicalDevice = physicalDevice;
+		queues = {};
+		for (size_t workload = 0; workload < QueueWorkloadCount; ++workload) {
+			const QueueAssignment& assignment = plan.Assignment(static_cast<QueueWorkload>(workload));
+			if (!plan.Has(static_cast<QueueWorkload>(workload)))
 				continue;
+			getDeviceQueue(logicalDevice, assignment.FamilyIndex, assignment.QueueIndex, queues.Queues[workload]);
+			queues.FamilyIndices[workload] = assignment.FamilyIndex;
+		}
+		return true;
+	}
 
-			std::vector<QueueInfo> requestedQueues = { {graphicsQueueFamilyIndex, { 1.0f }} };
-			if (graphicsQueueFamilyIndex != computeQueueFamilyIndex)
-				requestedQueues.push_back({ computeQueueFamilyIndex, { 1.0f } });
-			if (!createLogicalDevice(physicalDevice, requestedQueues, {}, &deviceFeatures, logicalDevice))
+	bool vkapp::createLogicalDeviceWithGeometryShadersAndGraphicsAndComputeQueues(VkInstance		 instance, 
+																				  LogicalDevice& logicalDevice, 
+																				  VkQueue&		 graphicsQueue, 
+																				  VkQueue&		 computeQueue){
+		DeviceRequirements requirements;
+		requirements.RequiredFeatures.geometryShader = VK_TRUE;
+		std::vector<DeviceScore> ranking;
+		if (!rankPhysicalDevices(instance, DefaultDeviceRankingPolicy(requirements), ranking))
+			return false;
+		for (auto& score : ranking) {
+			if (!score.Suitable)
+				break;
+			VkPhysicalDevice physicalDevice = score.Device->Handle();
+			VkPhysicalDeviceFeatures deviceFeatures = {};
+			deviceFeatures.geometryShader = VK_TRUE;
+			QueuePlan plan;
+			if (!planQueues(physicalDevice, VK_NULL_HANDLE, WorkloadBit(QueueWorkload::Graphics) | WorkloadBit(QueueWorkload::AsyncCompute), plan))
 				continue;
-			else{
-				if (!loadDeviceLevelFunctions(logicalDevice, {}))
-					return false;
-				getDeviceQueue(logicalDevice, graphicsQueueFamilyIndex, 0, graphicsQueue);
-				getDeviceQueue(logicalDevice, computeQueueFamilyIndex, 0, computeQueue);
-				return true;
-			}
+			QueueMap queues;
+			if (!createLogicalDeviceWithQueuePlan(physicalDevice, plan, {}, &deviceFeatures, logicalDevice, queues))
+				continue;
+			graphicsQueue = queues.Get(QueueWorkload::Graphics);
+			computeQueue = queues.Get(QueueWorkload::AsyncCompute);
+			return true;
 		}
 		return false;
 	}
 	void vkapp::destroyLogicalDevice(VkDevice& logicalDevice){
 		if (logicalDevice) {
-			vkDestroyDevice(logicalDevice, nullptr);
+			vkDestroyDevice(logicalDevice, deviceHostArena.Callbacks());
 			logicalDevice = VK_NULL_HANDLE;
 		}
 	}
 
+	void vkapp::destroyLogicalDevice(LogicalDevice& logicalDevice){
+		if (logicalDevice.Handle) {
+			//a table that failed to load partway may lack vkDestroyDevice; the device still has to go
+			PFN_vkDestroyDevice destroyDevice = logicalDevice.Dispatch.vkDestroyDevice;
+			if (!destroyDevice)
+				destroyDevice = (PFN_vkDestroyDevice)vkGetDeviceProcAddr(logicalDevice.Handle, "vkDestroyDevice");
+			if (!destroyDevice)
+				destroyDevice = vkDestroyDevice;
+			destroyDevice(logicalDevice.Handle, logicalDevice.HostCallbacks);
+			logicalDevice.Handle = VK_NULL_HANDLE;
+			logicalDevice.PhysicalDevice = VK_NULL_HANDLE;
+			logicalDevice.Dispatch = {};
+			logicalDevice.HostCallbacks = nullptr;
+		}
+	}
+
 	void vkapp::destroyInstance(VkInstance& instance) {
 		if (instance) {
-			vkDestroyInstance(instance, nullptr);
+			vkDestroyInstance(instance, instanceHostArena.Callbacks());
 			instance = VK_NULL_HANDLE;
+			//physical device handles die with the instance that enumerated them
+			physicalDeviceInfoCache.clear();
+		}
+	}
+
+	void vkapp::destroyInstance(VulkanInstance& instance) {
+		if (instance.Handle) {
+			//a table that failed to load partway may lack vkDestroyInstance; the instance still has to go
+			PFN_vkDestroyInstance destroy = instance.Dispatch.vkDestroyInstance;
+			if (!destroy)
+				destroy = (PFN_vkDestroyInstance)vkGetInstanceProcAddr(instance.Handle, "vkDestroyInstance");
+			destroy(instance.Handle, instance.HostCallbacks);
+			instance.Handle = VK_NULL_HANDLE;
+			instance.Dispatch = {};
+			instance.HostCallbacks = nullptr;
+			physicalDeviceInfoCache.clear();
 		}
 	}
 
@@ -359,7 +598,7 @@ namespace VulkanCookbook {
 				windowParameters.HInstance,						 //hinstance
 				windowParameters.HWnd							 //hwnd
 			};
-			result = vkCreateWin32SurfaceKHR(instance, &surfaceCreateInfo, nullptr, &presentationSurface);
+			result = vkCreateWin32SurfaceKHR(instance, &surfaceCreateInfo, instanceHostArena.Callbacks(), &presentationSurface);
 		#elif defined VK_USE_PLATFORM_XLIB_KHR
 			VkXlibSurfaceCreateInfoKHR surfaceCreateInfo = {
 				VK_STRUCTURE_TYPE_XLIB_SURFACE_CREATE_INFO_KHR, //sType
@@ -368,7 +607,7 @@ namespace VulkanCookbook {
 				windowParameters.Dpy,							//dpy
 				windowParameters.Window							//window
 			};
-			result = vkCreateXlibSurfaceKHR(instance, &surfaceCreateInfo, nullptr, &presentationSurface);
+			result = vkCreateXlibSurfaceKHR(instance, &surfaceCreateInfo, instanceHostArena.Callbacks(), &presentationSurface);
 		#elif defined VK_USE_PLATFORM_XCB_KHR
 			VkXcbSurfaceCreateInfoKHRf surfaceCreateInfo = {
 				VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR //sType
@@ -377,7 +616,7 @@ namespace VulkanCookbook {
 				windowParameters.Connection,				  //connection
 				windowParameters.Window						  //window
 		}
-			result = vkCreateWin32SurfaceKHR(instance, &surfaceCreateInfo, nullptr, &presentationSurface);
+			result = vkCreateWin32SurfaceKHR(instance, &surfaceCreateInfo, instanceHostArena.Callbacks(), &presentationSurface);
 		#endif 
 		if( (VK_SUCCESS != result) ||
 		(VK_NULL_HANDLE == presentationSurface)) 
@@ -390,10 +629,10 @@ namespace VulkanCookbook {
 	bool vkapp::selectQueueFamilyThatSupportsPresentationToGivenSurface(VkPhysicalDevice physicalDevice, 
 																		VkSurfaceKHR	 presentationSurface, 
 																		uint32_t&		 queueFamilyIndex){
-		std::vector<VkQueueFamilyProperties> queueFamilies;
-		if (!checkAvailableQueueFamiliesAndTheirProperties(physicalDevice, queueFamilies))
+		const PhysicalDeviceInfo* deviceInfo = getPhysicalDeviceInfo(physicalDevice);
+		if (!deviceInfo)
 			return false;
-		for (int index = 0; index < static_cast<int>(queueFamilies.size()); ++index) {
+		for (int index = 0; index < static_cast<int>(deviceInfo->QueueFamilies().size()); ++index) {
 			VkBool32 presentationSupported = VK_FALSE;
 			VkResult result = vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, index, 
 																	presentationSurface, &presentationSupported);
@@ -444,8 +683,11 @@ namespace VulkanCookbook {
 		return (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, presentationSurface, &surfaceCapabilities)
 				==VK_SUCCESS);
 	}
-	bool vkapp::selectNumberOfSwapchainImages(const VkSurfaceCapabilitiesKHR& surfaceCapabilities, uint32_t& numberOfImages){
-		numberOfImages = surfaceCapabilities.minImageCount + 1;
+	bool vkapp::selectNumberOfSwapchainImages(const VkSurfaceCapabilitiesKHR& surfaceCapabilities, uint32_t& numberOfImages,
+											  uint32_t desired){
+		numberOfImages = desired == 0 ? surfaceCapabilities.minImageCount + 1 : desired;
+		if (numberOfImages < surfaceCapabilities.minImageCount)
+			numberOfImages = surfaceCapabilities.minImageCount;
 		if (uint32_t maxImgCount = surfaceCapabilities.maxImageCount; maxImgCount > 0 && 
 			numberOfImages > maxImgCount)
 				numberOfImages = maxImgCount;
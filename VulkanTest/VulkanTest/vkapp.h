@@ -1,9 +1,51 @@
 #pragma once
-#include "Common.h"
+#include "DeviceSelection.h"
+#include "QueuePlanner.h"
+#include "HostArena.h"
 namespace VulkanCookbook {
 	class vkapp {
 	 public:
+		struct FunctionLoadingTimings {
+			Milliseconds GlobalLevel{};
+			Milliseconds InstanceLevel{};
+			Milliseconds DeviceLevel{};
+			Milliseconds InstanceDispatchTable{};
+			Milliseconds DeviceDispatchTable{};
+		};
+		//Duration of the most recent call to each function loader.
+		static FunctionLoadingTimings functionLoadingTimings;
+		//Prints the timings of the loaders that have run; call once device-level loading is done.
+		static void reportFunctionLoadingTimings();
+		//Driver host memory of the instance and its surfaces, and of the devices created here.
+		static HostArena instanceHostArena;
+		static HostArena deviceHostArena;
+		static void reportHostAllocations();
+		static const PhysicalDeviceInfo* getPhysicalDeviceInfo(VkPhysicalDevice);
+		//Scores every physical device of the instance with the given policy, best first.
+		static bool rankPhysicalDevices(VkInstance, const DeviceRankingPolicy&, std::vector<DeviceScore>&);
+		//Connects with the loader and loads its exported and global-level functions.
+		static bool loadVulkanLibrary(LIBRARY_TYPE&);
+		static void releaseVulkanLoaderLibrary(LIBRARY_TYPE&);
+		//Creates the instance and loads its table, along with the instance-level functions the helpers
+		//here call; createInfo's extensions decide which extension functions are loaded.
+		static bool createVulkanInstance(const VkInstanceCreateInfo&, const VkAllocationCallbacks*, VulkanInstance&);
+		static void destroyInstance(VulkanInstance&);
+		static bool loadInstanceDispatchTable(VkInstance, const std::vector<const char*>&, InstanceDispatchTable&);
+		static bool loadDeviceLevelFunctions(VkDevice, const std::vector<const char*>&);
+		static bool loadDeviceDispatchTable(VkDevice, const std::vector<const char*>&, DeviceDispatchTable&);
+		static bool planQueues(VkPhysicalDevice, VkSurfaceKHR, uint32_t, QueuePlan&);
+		//next is the device create info's pNext chain, for feature structures of extensions.
+		static bool createLogicalDeviceWithQueuePlan(VkPhysicalDevice, const QueuePlan&, const std::vector<const char*>&,
+													 VkPhysicalDeviceFeatures*, LogicalDevice&, QueueMap&, const void* next = nullptr);
+		static void destroyLogicalDevice(LogicalDevice&);
+		//desired 0 asks for one image more than the minimum; any other count is clamped to what the surface allows
+		static bool selectNumberOfSwapchainImages(const VkSurfaceCapabilitiesKHR&, uint32_t&, uint32_t desired = 0);
 	 private:
+		//Instance extensions are enumerated once; everything about a physical device,
+		//its extensions included, once per device.
+		static std::optional<ExtensionSet>								instanceExtensionCache;
+		static std::unordered_map<VkPhysicalDevice, PhysicalDeviceInfo> physicalDeviceInfoCache;
+
 		struct QueueInfo {
 			uint32_t		   FamilyIndex;
 			std::vector<float> Priorities;
@@ -12,23 +54,24 @@ namespace VulkanCookbook {
 		static bool ConnectWithVulkanLoaderLibrary(LIBRARY_TYPE& vulkan_library);
 		static bool LoadGlobalLevelFunctions();
 		static bool CheckAvailableInstanceExtensions(std::vector<VkExtensionProperties>& availableExtensions);
+		static const ExtensionSet* getAvailableInstanceExtensions();
 		static bool CreateVulkanInstance(std::vector<char const *> const& desiredExtensions, const char* const applicationName,
 			VkInstance& instance);
 		static bool LoadInstanceLevelFunctions(VkInstance, const std::vector<const char*>&);
 		static bool EnumerateAvailablePhysicalDevices(VkInstance instance, std::vector<VkPhysicalDevice>&);
 		static bool checkAvailableDeviceExtensions(VkPhysicalDevice, std::vector<VkExtensionProperties>&);
+		static const ExtensionSet* getAvailableDeviceExtensions(VkPhysicalDevice);
 		static void getFeaturesAndPropertiesOfPhysicalDevice(VkPhysicalDevice, VkPhysicalDeviceFeatures&,
 															 VkPhysicalDeviceProperties&);
 		static bool checkAvailableQueueFamiliesAndTheirProperties(VkPhysicalDevice, std::vector<VkQueueFamilyProperties>&);
 		static bool selectIndexOfQueueFamilyWithDesiredCapabilities(VkPhysicalDevice, VkQueueFlags, uint32_t&);
 		static bool createLogicalDevice(VkPhysicalDevice, std::vector<QueueInfo>, const std::vector<const char*>&, VkPhysicalDeviceFeatures*,
-										VkDevice);
-		static bool loadDeviceLevelFunctions(VkDevice, const std::vector<const char*>&);
+										VkDevice&, const void* next = nullptr);
 		static void getDeviceQueue(VkDevice, uint32_t, uint32_t, VkQueue&);
-		static bool createLogicalDeviceWithGeometryShadersAndGraphicsAndComputeQueues(VkInstance, VkDevice&, VkQueue&, VkQueue&);
+		static void getDeviceQueue(const LogicalDevice&, uint32_t, uint32_t, VkQueue&);
+		static bool createLogicalDeviceWithGeometryShadersAndGraphicsAndComputeQueues(VkInstance, LogicalDevice&, VkQueue&, VkQueue&);
 		static void destroyLogicalDevice(VkDevice&);
 		static void destroyInstance(VkInstance&);
-		static void releaseVulkanLoaderLibrary(LIBRARY_TYPE&);
 		static bool createVulkanInstanceWithExtensionsEnabled(std::vector<const char*>&, const char* const, VkInstance&);
 		static bool createPresentationSurface(VkInstance, WindowParameters, VkSurfaceKHR&);
 		static bool selectQueueFamilyThatSupportsPresentationToGivenSurface(VkPhysicalDevice, VkSurfaceKHR, uint32_t&);
@@ -36,7 +79,6 @@ namespace VulkanCookbook {
 																std::vector<const char*>&, VkPhysicalDeviceFeatures*, VkDevice&);
 		static bool	selectDesiredPresentationMode(VkPhysicalDevice, VkSurfaceKHR, VkPresentModeKHR, VkPresentModeKHR&);
 		static bool getCapabilitiesOfPresentationSurface(VkPhysicalDevice, VkSurfaceKHR, VkSurfaceCapabilitiesKHR&);
-		static bool selectNumberOfSwapchainImages(const VkSurfaceCapabilitiesKHR&, uint32_t&);
 		static bool chooseSizeOfSwapchainImages(const VkSurfaceCapabilitiesKHR&, VkExtent2D&);
 		static bool selectDesiredUsageScenariosOfSwapchainImages(const VkSurfaceCapabilitiesKHR&, VkImageUsageFlags, VkImageUsageFlags);
 	};